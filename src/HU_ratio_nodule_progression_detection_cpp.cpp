@@ -0,0 +1,106 @@
+#include <Rcpp.h>
+#include <vector>
+#include "detection_matrix.h"
+#include "hu_ratio.h"
+#include "npds.h"
+using namespace Rcpp;
+
+// 所有切片的 HU 比值检测，取代 HU_ratio_nodule_progression_detectionC 中逐切片调用
+// HU_ratio_nodule_progression_detection_slice_cpp 的循环
+// A1、A2 为 generate_lung_tissue_blocksC 的结果，维度为 c(M, block_num, split_size^2)；
+// 结节块取 A1、A2 的第 (anno_i - 1) * split_num 行，或取维度为 c(M, 2, split_size^2) 的 nodule_block_list
+// 变化率按 (组织块, 切片段) 划分任务、检测按切片用 nthreads 个 OpenMP 线程并行计算，
+// 所有结果直接写入预先分配的返回值；每个元素只由一个任务按固定顺序计算，结果与线程数无关，
+// 与逐切片调用 HU_ratio_nodule_progression_detection_slice_cpp 的结果逐位一致
+// 返回值与 HU_ratio_nodule_progression_detectionC 相同；detection_format 不为 "double" 时检测矩阵紧凑存储（见 detection_matrix.h）
+// [[Rcpp::export]]
+List HU_ratio_nodule_progression_detection_cpp(
+    NumericVector A1,        // 基线图像的组织块
+    NumericVector A2,        // 随访图像的组织块
+    Nullable<int> anno_i,    // 可选的i坐标
+    Nullable<int> anno_j,    // 可选的j坐标
+    Nullable<NumericVector> nodule_block_list, // 结节块列表
+    int split_num,  // 每行每列的分块数
+    NumericVector detection_threshold, // 阈值
+    bool compact = false,
+    int nthreads = 1,
+    std::string detection_format = "double"  // 检测矩阵的存储方式："double"、"int8" 或 "bits"
+) {
+  IntegerVector dims = A1.attr("dim");
+  if (dims.size() != 3) {
+    stop("A1 must be a 3D array of c(M, block_num, split_size^2).");
+  }
+  IntegerVector dims_2 = A2.attr("dim");
+  if (dims_2.size() != 3 || dims_2[0] != dims[0] || dims_2[1] != dims[1] || dims_2[2] != dims[2]) {
+    stop("A1 and A2 must have the same dimensions.");
+  }
+
+  int M = dims[0];
+  int n_rows = dims[1];
+  int n_pixels = dims[2];
+  int block_num = split_num * split_num;
+  int R = detection_threshold.size();
+  if (block_num > n_rows) {
+    stop("block_1d_index exceeds block_num.");
+  }
+
+  if (nthreads < 1) nthreads = 1;
+#ifndef _OPENMP
+  nthreads = 1;
+#endif
+  DetectionFormat format = parse_detection_format(detection_format, "HU_ratio_nodule_progression_detection_cpp");
+
+  HURatioBlockLayout layout;
+  layout.A[0] = REAL(A1);
+  layout.A[1] = REAL(A2);
+  layout.block_stride = M;
+  layout.pixel_stride = static_cast<std::ptrdiff_t>(M) * n_rows;
+  layout.slice_stride = 1;
+
+  // 判断是否有指定的 i 和 j 坐标
+  if (anno_i.isNotNull() && anno_j.isNotNull()) {
+    // 计算结节块所在的行
+    int index = (as<int>(anno_i) - 1) * split_num;
+    if (index < 0 || index >= n_rows) {
+      stop("anno_i is out of range.");
+    }
+    layout.nodule_ptr[0] = layout.A[0] + static_cast<std::ptrdiff_t>(M) * index;
+    layout.nodule_ptr[1] = layout.A[1] + static_cast<std::ptrdiff_t>(M) * index;
+    layout.nodule_stride = layout.pixel_stride;
+  } else {
+    if (nodule_block_list.isNull()) {
+      stop("nodule_block_list is required when anno_i and anno_j are not given.");
+    }
+    NumericVector nbl(nodule_block_list.get());
+    IntegerVector nbl_dims = nbl.attr("dim");
+    if (nbl_dims.size() != 3 || nbl_dims[0] != M || nbl_dims[1] != 2 || nbl_dims[2] != n_pixels) {
+      stop("nodule_block_list must be an array of c(M, 2, split_size^2).");
+    }
+    layout.nodule_ptr[0] = REAL(nbl);
+    layout.nodule_ptr[1] = REAL(nbl) + M;
+    layout.nodule_stride = 2 * static_cast<std::ptrdiff_t>(M);
+  }
+
+  NumericMatrix detection_list(M, R);
+  NumericVector NPDSt(compact ? M : 0);
+
+  std::vector<double> change(static_cast<std::size_t>(M) * block_num);
+  // image_size = 512、split_size = 32 或 64 时组织块数与像素数使用编译期常量（见 BlockSize）
+  if (block_num == 16 * 16 && n_pixels == 32 * 32) {
+    _hu_ratio_change_tasks<16 * 16, 32 * 32>(layout, M, block_num, n_pixels, change.data(), nthreads);
+  } else if (block_num == 8 * 8 && n_pixels == 64 * 64) {
+    _hu_ratio_change_tasks<8 * 8, 64 * 64>(layout, M, block_num, n_pixels, change.data(), nthreads);
+  } else {
+    _hu_ratio_change_tasks(layout, M, block_num, n_pixels, change.data(), nthreads);
+  }
+  if (compact) {
+    _hu_ratio_detection_slices(change.data(), M, block_num, REAL(detection_threshold), R,
+                               static_cast<double *>(NULL), REAL(detection_list), REAL(NPDSt), nthreads);
+    return List::create(Named("detection_list") = detection_list,
+                        Named("NPDSt") = NPDSt);
+  }
+  RObject detection_matrix = _hu_ratio_detection_matrix(change.data(), M, block_num, REAL(detection_threshold), R,
+                                                        format, REAL(detection_list), nthreads);
+  return List::create(Named("detection_matrix") = detection_matrix,
+                      Named("detection_list") = detection_list);
+}
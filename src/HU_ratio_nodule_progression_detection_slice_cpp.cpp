@@ -1,6 +1,14 @@
 #include <Rcpp.h>
+#include <cmath>
+#include <vector>
+#include "hu_ratio.h"
+#include "npds.h"
+#include "volume_utils.h"
 using namespace Rcpp;
 
+// compact 为 TRUE 时不生成 detection_matrix_slice：检测列表由排序后的变化率直接得到，
+// 并返回检测列表在阈值范围上的梯形积分 NPDSt_slice（与 trapz_rcpp 的结果相同）
+// workspace 为 npds_workspace() 创建的工作区时，比值累加与排序工作区取自其中，逐张切片调用时不再重新分配
 // [[Rcpp::export]]
 List HU_ratio_nodule_progression_detection_slice_cpp(
     NumericMatrix A1_slice,  // 基线图像的切片
@@ -10,17 +18,35 @@ List HU_ratio_nodule_progression_detection_slice_cpp(
     NumericMatrix nodule_block_list_slice, // 结节块列表
     int split_num,  // 每行每列的分块数
     int block_num,  // 总块数
-    NumericVector detection_threshold // 阈值
+    NumericVector detection_threshold, // 阈值
+    bool compact = false, // 是否只返回检测列表和积分结果
+    SEXP workspace = R_NilValue // 可选的工作区
 ) {
   // 动态计算 R
   int R = detection_threshold.size();
 
   // 初始化返回值矩阵
-  NumericMatrix detection_matrix_slice(R, split_num * split_num);  // 检测矩阵
+  NumericMatrix detection_matrix_slice(compact ? 0 : R, compact ? 0 : split_num * split_num);  // 检测矩阵
   NumericVector detection_list_slice(R);      // 检测列表
   NumericVector change_ratio_matrix_slice(split_num * split_num); // 变化率矩阵
 
-  NumericVector nodule_block_1, nodule_block_2;
+  int n_blocks = split_num * split_num;
+
+  // 检查 block_1d_index 是否超出 block_num 范围
+  if (n_blocks > block_num) {
+    stop("block_1d_index exceeds block_num.");
+  }
+  if (A1_slice.nrow() < n_blocks || A2_slice.nrow() != A1_slice.nrow() ||
+      A2_slice.ncol() != A1_slice.ncol()) {
+    stop("A1_slice and A2_slice must have the same size and at least split_num^2 rows.");
+  }
+
+  int n_pixels = A1_slice.ncol();
+  std::ptrdiff_t ld = A1_slice.nrow();  // 列优先存储，同一像素在各组织块中的值连续
+
+  // 结节块的第 p 个像素位于 nodule_block_s[p * nodule_stride]
+  const double *nodule_block_1, *nodule_block_2;
+  std::ptrdiff_t nodule_stride;
 
   // 判断是否有指定的 i 和 j 坐标
   if (anno_i.isNotNull() && anno_j.isNotNull()) {
@@ -29,66 +55,76 @@ List HU_ratio_nodule_progression_detection_slice_cpp(
 
     // 计算切片的索引
     int index = (i - 1) * split_num;
+    if (index < 0 || index >= A1_slice.nrow()) {
+      stop("anno_i is out of range.");
+    }
 
-    nodule_block_1 = A1_slice.row(index);  // 赋值而非重新声明
-    nodule_block_2 = A2_slice.row(index);  // 赋值而非重新声明
+    nodule_block_1 = REAL(A1_slice) + index;
+    nodule_block_2 = REAL(A2_slice) + index;
+    nodule_stride = ld;
   } else {
-    nodule_block_1 = nodule_block_list_slice.row(0);  // 赋值
-    nodule_block_2 = nodule_block_list_slice.row(1);  // 赋值
+    if (nodule_block_list_slice.nrow() != 2 || nodule_block_list_slice.ncol() != n_pixels) {
+      stop("nodule_block_list_slice must be a 2 x split_size^2 matrix.");
+    }
+    nodule_block_1 = REAL(nodule_block_list_slice);
+    nodule_block_2 = nodule_block_1 + 1;
+    nodule_stride = 2;
   }
 
-  // 用于调试的计数器
-  int count = 0;
+  // 像素在外层、组织块在内层：融合累加核沿组织块方向向量化，结节像素广播到所有组织块，
+  // 不再为每个组织块拷贝行或生成比例的临时向量
+  NPDSWorkspace local;
+  NPDSWorkspace *ws = workspace_arg(workspace, local, 1, "HU_ratio_nodule_progression_detection_slice_cpp");
+  NPDSThreadWork &work = ws->threads[0];
+  std::vector<double> &acc = work.acc;
+  acc.assign(2 * static_cast<std::size_t>(n_blocks), 0.0);
+  double *acc_1 = acc.data();
+  double *acc_2 = acc_1 + n_blocks;
+  for (int p = 0; p < n_pixels; p++) {
+    _hu_ratio_accumulate(nodule_block_1 + p * nodule_stride, REAL(A1_slice) + p * ld,
+                         nodule_block_2 + p * nodule_stride, REAL(A2_slice) + p * ld,
+                         0, acc_1, acc_2, n_blocks);
+  }
 
   // 遍历所有的分块
-  for (int i = 0; i < split_num; i++) {
-    for (int j = 0; j < split_num; j++) {
-      // 计算一维索引
-      int block_1d_index = i * split_num + j;
-
-      // 检查 block_1d_index 是否超出 block_num 范围
-      if (block_1d_index >= block_num) {
-        Rcpp::Rcout << "Error: block_1d_index exceeds block_num: "
-                    << block_1d_index << std::endl;
-        stop("block_1d_index exceeds block_num.");
-      }
-
-      // 打印调试信息，查看索引是否正确
-      //Rcpp::Rcout << "Processing block: " << count++ << ", block_1d_index: "
-                  //<< block_1d_index << std::endl;
-
-      // 从 A1 和 A2 中提取当前块
-      NumericVector block_1_now = A1_slice.row(block_1d_index);
-      NumericVector block_2_now = A2_slice.row(block_1d_index);
-
-      // 计算比例
-      NumericVector ratio_1 = nodule_block_1 / abs(block_1_now + 0.1);
-      NumericVector ratio_2 = nodule_block_2 / abs(block_2_now + 0.1);
-
-      // 计算变化率
-      double mean_ratio_1 = mean(ratio_1);
-      double mean_ratio_2 = mean(ratio_2);
-      double change = (mean_ratio_2 - mean_ratio_1) / abs(mean_ratio_1);
-
-      // 更新 change_ratio_matrix
-      change_ratio_matrix_slice[block_1d_index] = change;
-
-      // 根据变化率更新 detection_matrix
-      for (int r = 0; r < R; r++) {
-        if (change > detection_threshold[r]) {
-          detection_matrix_slice(r, block_1d_index) = 1.0;
-        } else if (change < -detection_threshold[r]) {
-          detection_matrix_slice(r, block_1d_index) = -1.0;
-        } else {
-          detection_matrix_slice(r, block_1d_index) = 0.0;
-        }
+  for (int block_1d_index = 0; block_1d_index < n_blocks; block_1d_index++) {
+    // 计算变化率
+    double mean_ratio_1 = acc_1[block_1d_index] / n_pixels;
+    double mean_ratio_2 = acc_2[block_1d_index] / n_pixels;
+    double change = (mean_ratio_2 - mean_ratio_1) / std::fabs(mean_ratio_1);
+
+    // 更新 change_ratio_matrix
+    change_ratio_matrix_slice[block_1d_index] = change;
+
+    if (compact) continue;
+
+    // 根据变化率更新 detection_matrix
+    for (int r = 0; r < R; r++) {
+      if (change > detection_threshold[r]) {
+        detection_matrix_slice(r, block_1d_index) = 1.0;
+      } else if (change < -detection_threshold[r]) {
+        detection_matrix_slice(r, block_1d_index) = -1.0;
+      } else {
+        detection_matrix_slice(r, block_1d_index) = 0.0;
       }
     }
   }
 
+  if (compact) {
+    // 不经过检测矩阵，直接由排序后的变化率得到检测列表并积分；与下面的完整路径一样除以 block_num
+    _hu_ratio_detection_sorted(REAL(change_ratio_matrix_slice), n_blocks,
+                               REAL(detection_threshold), R,
+                               REAL(detection_list_slice), 1, work.pos, work.neg, block_num);
+    double NPDSt_slice = _trapz(REAL(detection_threshold), REAL(detection_list_slice), R);
+    return List::create(Named("detection_list_slice") = detection_list_slice,
+                        Named("NPDSt_slice") = NPDSt_slice);
+  }
+
   // 计算每个块的检测值
   for (int r = 0; r < R; r++) {
-    detection_list_slice[r] = sum(detection_matrix_slice(r,_)) / block_num;  // 每个块的平均检测值
+    double total = 0.0;
+    for (int b = 0; b < n_blocks; b++) total += detection_matrix_slice(r, b);
+    detection_list_slice[r] = total / block_num;  // 每个块的平均检测值
   }
 
 
@@ -0,0 +1,86 @@
+#include <Rcpp.h>
+#include <vector>
+#include "detection_matrix.h"
+#include "hu_ratio.h"
+#include "npds.h"
+#include "typed_volume.h"
+#include "volume_utils.h"
+using namespace Rcpp;
+
+// 按存储类型计算所有切片的 HU 比值变化率
+struct ChangeVolumeTask {
+  VolumeLayout volume;
+  int x_start, y_start, split_size, split_num;
+  double *change;
+  int nthreads;
+
+  template <class T>
+  void operator()(const T *bf, const T *af) {
+    _hu_ratio_change_volume(bf, af, volume, x_start, y_start, split_size, split_num,
+                            change, nthreads);
+  }
+};
+
+// 整个体数据的 HU 比值检测
+// 组织块和结节块都通过块视图直接从 bf_sub_image / af_sub_image 中读取，
+// 不再生成 generate_lung_tissue_blocksC 和 generate_nodule_block_listC 的中间数组
+// x_start、y_start 为结节块左上角的 0 起始下标，与 generate_nodule_block_listC 中的计算方式相同
+// 返回值与 HU_ratio_nodule_progression_detectionC 相同：
+//   detection_matrix 维度为 c(R, M, block_num)，detection_list 维度为 c(M, R)
+// detection_format 为 "int8" 或 "bits" 时检测矩阵紧凑存储（见 detection_matrix.h），结果与 "double" 相同
+// compact 为 TRUE 时不生成 detection_matrix，检测列表由排序后的变化率直接得到，
+// 并同时返回每张切片在阈值范围上的积分 NPDSt
+// 子区域可以是 double 数组，也可以是 npds_storage() 生成的 int16 / float32 体数据
+// 带 npds_layout = "xyz" 属性的子区域（npds_native()）按 NIfTI 原始布局通过步长读取，不需要 aperm
+// nthreads 为 OpenMP 线程数：变化率按 (组织块, 切片段) 并行，检测按切片并行，结果与线程数无关
+// [[Rcpp::export]]
+List HU_ratio_nodule_progression_detection_volume_cpp(
+    SEXP bf_sub_image,           // 基线CT子区域 [z, y, x]
+    SEXP af_sub_image,           // 随访CT子区域 [z, y, x]
+    int x_start,                 // 结节块起始列
+    int y_start,                 // 结节块起始行
+    int split_size,
+    int image_size,
+    NumericVector detection_threshold, // 阈值
+    bool compact = false,
+    int nthreads = 1,
+    std::string detection_format = "double"  // 检测矩阵的存储方式："double"、"int8" 或 "bits"
+) {
+  const char *caller = "HU_ratio_nodule_progression_detection_volume_cpp";
+  TypedVolume bf = typed_volume(bf_sub_image, caller);
+  TypedVolume af = typed_volume(af_sub_image, caller);
+  int bf_dims[3] = {bf.n_slices, bf.nrow, bf.ncol};
+  int af_dims[3] = {af.n_slices, af.nrow, af.ncol};
+  int split_num = check_block_geometry(bf_dims, af_dims, x_start, y_start, split_size, image_size, caller);
+  int M = bf.n_slices;
+  int block_num = split_num * split_num;
+  int R = detection_threshold.size();
+
+  if (nthreads < 1) nthreads = 1;
+#ifndef _OPENMP
+  nthreads = 1;
+#endif
+  DetectionFormat format = parse_detection_format(detection_format, caller);
+
+  NumericMatrix detection_list(M, R);
+  NumericVector NPDSt(compact ? M : 0);
+
+  const double *threshold = REAL(detection_threshold);
+  double *dl = REAL(detection_list);
+
+  std::vector<double> change(static_cast<std::size_t>(M) * block_num);
+  ChangeVolumeTask task = {volume_layout(bf), x_start, y_start, split_size, split_num,
+                           change.data(), nthreads};
+  dispatch_storage_pair(bf, af, task, caller);
+
+  if (compact) {
+    _hu_ratio_detection_slices(change.data(), M, block_num, threshold, R, static_cast<double *>(NULL), dl,
+                               REAL(NPDSt), nthreads);
+    return List::create(Named("detection_list") = detection_list,
+                        Named("NPDSt") = NPDSt);
+  }
+  RObject detection_matrix = _hu_ratio_detection_matrix(change.data(), M, block_num, threshold, R, format, dl,
+                                                        nthreads);
+  return List::create(Named("detection_matrix") = detection_matrix,
+                      Named("detection_list") = detection_list);
+}
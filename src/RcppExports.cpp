@@ -10,9 +10,29 @@ Rcpp::Rostream<true>&  Rcpp::Rcout = Rcpp::Rcpp_cout_get();
 Rcpp::Rostream<false>& Rcpp::Rcerr = Rcpp::Rcpp_cerr_get();
 #endif
 
+// HU_ratio_nodule_progression_detection_cpp
+List HU_ratio_nodule_progression_detection_cpp(NumericVector A1, NumericVector A2, Nullable<int> anno_i, Nullable<int> anno_j, Nullable<NumericVector> nodule_block_list, int split_num, NumericVector detection_threshold, bool compact, int nthreads, std::string detection_format);
+RcppExport SEXP _NPDS4Clib_HU_ratio_nodule_progression_detection_cpp(SEXP A1SEXP, SEXP A2SEXP, SEXP anno_iSEXP, SEXP anno_jSEXP, SEXP nodule_block_listSEXP, SEXP split_numSEXP, SEXP detection_thresholdSEXP, SEXP compactSEXP, SEXP nthreadsSEXP, SEXP detection_formatSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericVector >::type A1(A1SEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type A2(A2SEXP);
+    Rcpp::traits::input_parameter< Nullable<int> >::type anno_i(anno_iSEXP);
+    Rcpp::traits::input_parameter< Nullable<int> >::type anno_j(anno_jSEXP);
+    Rcpp::traits::input_parameter< Nullable<NumericVector> >::type nodule_block_list(nodule_block_listSEXP);
+    Rcpp::traits::input_parameter< int >::type split_num(split_numSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type detection_threshold(detection_thresholdSEXP);
+    Rcpp::traits::input_parameter< bool >::type compact(compactSEXP);
+    Rcpp::traits::input_parameter< int >::type nthreads(nthreadsSEXP);
+    Rcpp::traits::input_parameter< std::string >::type detection_format(detection_formatSEXP);
+    rcpp_result_gen = Rcpp::wrap(HU_ratio_nodule_progression_detection_cpp(A1, A2, anno_i, anno_j, nodule_block_list, split_num, detection_threshold, compact, nthreads, detection_format));
+    return rcpp_result_gen;
+END_RCPP
+}
 // HU_ratio_nodule_progression_detection_slice_cpp
-List HU_ratio_nodule_progression_detection_slice_cpp(NumericMatrix A1_slice, NumericMatrix A2_slice, Nullable<int> anno_i, Nullable<int> anno_j, NumericMatrix nodule_block_list_slice, int split_num, int block_num, NumericVector detection_threshold);
-RcppExport SEXP _NPDS4Clib_HU_ratio_nodule_progression_detection_slice_cpp(SEXP A1_sliceSEXP, SEXP A2_sliceSEXP, SEXP anno_iSEXP, SEXP anno_jSEXP, SEXP nodule_block_list_sliceSEXP, SEXP split_numSEXP, SEXP block_numSEXP, SEXP detection_thresholdSEXP) {
+List HU_ratio_nodule_progression_detection_slice_cpp(NumericMatrix A1_slice, NumericMatrix A2_slice, Nullable<int> anno_i, Nullable<int> anno_j, NumericMatrix nodule_block_list_slice, int split_num, int block_num, NumericVector detection_threshold, bool compact, SEXP workspace);
+RcppExport SEXP _NPDS4Clib_HU_ratio_nodule_progression_detection_slice_cpp(SEXP A1_sliceSEXP, SEXP A2_sliceSEXP, SEXP anno_iSEXP, SEXP anno_jSEXP, SEXP nodule_block_list_sliceSEXP, SEXP split_numSEXP, SEXP block_numSEXP, SEXP detection_thresholdSEXP, SEXP compactSEXP, SEXP workspaceSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -24,18 +44,41 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< int >::type split_num(split_numSEXP);
     Rcpp::traits::input_parameter< int >::type block_num(block_numSEXP);
     Rcpp::traits::input_parameter< NumericVector >::type detection_threshold(detection_thresholdSEXP);
-    rcpp_result_gen = Rcpp::wrap(HU_ratio_nodule_progression_detection_slice_cpp(A1_slice, A2_slice, anno_i, anno_j, nodule_block_list_slice, split_num, block_num, detection_threshold));
+    Rcpp::traits::input_parameter< bool >::type compact(compactSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type workspace(workspaceSEXP);
+    rcpp_result_gen = Rcpp::wrap(HU_ratio_nodule_progression_detection_slice_cpp(A1_slice, A2_slice, anno_i, anno_j, nodule_block_list_slice, split_num, block_num, detection_threshold, compact, workspace));
+    return rcpp_result_gen;
+END_RCPP
+}
+// HU_ratio_nodule_progression_detection_volume_cpp
+List HU_ratio_nodule_progression_detection_volume_cpp(SEXP bf_sub_image, SEXP af_sub_image, int x_start, int y_start, int split_size, int image_size, NumericVector detection_threshold, bool compact, int nthreads, std::string detection_format);
+RcppExport SEXP _NPDS4Clib_HU_ratio_nodule_progression_detection_volume_cpp(SEXP bf_sub_imageSEXP, SEXP af_sub_imageSEXP, SEXP x_startSEXP, SEXP y_startSEXP, SEXP split_sizeSEXP, SEXP image_sizeSEXP, SEXP detection_thresholdSEXP, SEXP compactSEXP, SEXP nthreadsSEXP, SEXP detection_formatSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type bf_sub_image(bf_sub_imageSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type af_sub_image(af_sub_imageSEXP);
+    Rcpp::traits::input_parameter< int >::type x_start(x_startSEXP);
+    Rcpp::traits::input_parameter< int >::type y_start(y_startSEXP);
+    Rcpp::traits::input_parameter< int >::type split_size(split_sizeSEXP);
+    Rcpp::traits::input_parameter< int >::type image_size(image_sizeSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type detection_threshold(detection_thresholdSEXP);
+    Rcpp::traits::input_parameter< bool >::type compact(compactSEXP);
+    Rcpp::traits::input_parameter< int >::type nthreads(nthreadsSEXP);
+    Rcpp::traits::input_parameter< std::string >::type detection_format(detection_formatSEXP);
+    rcpp_result_gen = Rcpp::wrap(HU_ratio_nodule_progression_detection_volume_cpp(bf_sub_image, af_sub_image, x_start, y_start, split_size, image_size, detection_threshold, compact, nthreads, detection_format));
     return rcpp_result_gen;
 END_RCPP
 }
 // bwlabel
-List bwlabel(NumericMatrix x);
-RcppExport SEXP _NPDS4Clib_bwlabel(SEXP xSEXP) {
+List bwlabel(NumericMatrix x, int connectivity);
+RcppExport SEXP _NPDS4Clib_bwlabel(SEXP xSEXP, SEXP connectivitySEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< NumericMatrix >::type x(xSEXP);
-    rcpp_result_gen = Rcpp::wrap(bwlabel(x));
+    Rcpp::traits::input_parameter< int >::type connectivity(connectivitySEXP);
+    rcpp_result_gen = Rcpp::wrap(bwlabel(x, connectivity));
     return rcpp_result_gen;
 END_RCPP
 }
@@ -89,15 +132,113 @@ BEGIN_RCPP
 END_RCPP
 }
 // clear_border
-NumericMatrix clear_border(NumericMatrix labels, int buffer_size, double bgval);
-RcppExport SEXP _NPDS4Clib_clear_border(SEXP labelsSEXP, SEXP buffer_sizeSEXP, SEXP bgvalSEXP) {
+NumericMatrix clear_border(NumericMatrix labels, int buffer_size, double bgval, int connectivity, SEXP workspace);
+RcppExport SEXP _NPDS4Clib_clear_border(SEXP labelsSEXP, SEXP buffer_sizeSEXP, SEXP bgvalSEXP, SEXP connectivitySEXP, SEXP workspaceSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< NumericMatrix >::type labels(labelsSEXP);
     Rcpp::traits::input_parameter< int >::type buffer_size(buffer_sizeSEXP);
     Rcpp::traits::input_parameter< double >::type bgval(bgvalSEXP);
-    rcpp_result_gen = Rcpp::wrap(clear_border(labels, buffer_size, bgval));
+    Rcpp::traits::input_parameter< int >::type connectivity(connectivitySEXP);
+    Rcpp::traits::input_parameter< SEXP >::type workspace(workspaceSEXP);
+    rcpp_result_gen = Rcpp::wrap(clear_border(labels, buffer_size, bgval, connectivity, workspace));
+    return rcpp_result_gen;
+END_RCPP
+}
+// read_sorted_column_cpp
+NumericVector read_sorted_column_cpp(std::string path, std::string column);
+RcppExport SEXP _NPDS4Clib_read_sorted_column_cpp(SEXP pathSEXP, SEXP columnSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type path(pathSEXP);
+    Rcpp::traits::input_parameter< std::string >::type column(columnSEXP);
+    rcpp_result_gen = Rcpp::wrap(read_sorted_column_cpp(path, column));
+    return rcpp_result_gen;
+END_RCPP
+}
+// sorted_exceedance_cpp
+NumericVector sorted_exceedance_cpp(NumericVector sorted, NumericVector x);
+RcppExport SEXP _NPDS4Clib_sorted_exceedance_cpp(SEXP sortedSEXP, SEXP xSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericVector >::type sorted(sortedSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type x(xSEXP);
+    rcpp_result_gen = Rcpp::wrap(sorted_exceedance_cpp(sorted, x));
+    return rcpp_result_gen;
+END_RCPP
+}
+// clinv_group_cpp
+IntegerVector clinv_group_cpp(NumericVector diameter_mm);
+RcppExport SEXP _NPDS4Clib_clinv_group_cpp(SEXP diameter_mmSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericVector >::type diameter_mm(diameter_mmSEXP);
+    rcpp_result_gen = Rcpp::wrap(clinv_group_cpp(diameter_mm));
+    return rcpp_result_gen;
+END_RCPP
+}
+// hypothesis_test_cpp
+List hypothesis_test_cpp(NumericVector npds, NumericVector diameter_mm, NumericVector percentiles, List reference);
+RcppExport SEXP _NPDS4Clib_hypothesis_test_cpp(SEXP npdsSEXP, SEXP diameter_mmSEXP, SEXP percentilesSEXP, SEXP referenceSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericVector >::type npds(npdsSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type diameter_mm(diameter_mmSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type percentiles(percentilesSEXP);
+    Rcpp::traits::input_parameter< List >::type reference(referenceSEXP);
+    rcpp_result_gen = Rcpp::wrap(hypothesis_test_cpp(npds, diameter_mm, percentiles, reference));
+    return rcpp_result_gen;
+END_RCPP
+}
+// content_hash_cpp
+std::string content_hash_cpp(CharacterVector paths, std::string extra);
+RcppExport SEXP _NPDS4Clib_content_hash_cpp(SEXP pathsSEXP, SEXP extraSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< CharacterVector >::type paths(pathsSEXP);
+    Rcpp::traits::input_parameter< std::string >::type extra(extraSEXP);
+    rcpp_result_gen = Rcpp::wrap(content_hash_cpp(paths, extra));
+    return rcpp_result_gen;
+END_RCPP
+}
+// volume_hash_cpp
+std::string volume_hash_cpp(SEXP x);
+RcppExport SEXP _NPDS4Clib_volume_hash_cpp(SEXP xSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type x(xSEXP);
+    rcpp_result_gen = Rcpp::wrap(volume_hash_cpp(x));
+    return rcpp_result_gen;
+END_RCPP
+}
+// pack_detection_matrix_cpp
+SEXP pack_detection_matrix_cpp(SEXP x, std::string detection_format);
+RcppExport SEXP _NPDS4Clib_pack_detection_matrix_cpp(SEXP xSEXP, SEXP detection_formatSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type x(xSEXP);
+    Rcpp::traits::input_parameter< std::string >::type detection_format(detection_formatSEXP);
+    rcpp_result_gen = Rcpp::wrap(pack_detection_matrix_cpp(x, detection_format));
+    return rcpp_result_gen;
+END_RCPP
+}
+// expand_detection_matrix_cpp
+NumericVector expand_detection_matrix_cpp(SEXP x, Nullable<IntegerVector> slices);
+RcppExport SEXP _NPDS4Clib_expand_detection_matrix_cpp(SEXP xSEXP, SEXP slicesSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type x(xSEXP);
+    Rcpp::traits::input_parameter< Nullable<IntegerVector> >::type slices(slicesSEXP);
+    rcpp_result_gen = Rcpp::wrap(expand_detection_matrix_cpp(x, slices));
     return rcpp_result_gen;
 END_RCPP
 }
@@ -148,15 +289,139 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// hu_ratio_reciprocal_cpp
+NumericVector hu_ratio_reciprocal_cpp(SEXP sub_image, int split_size, int image_size, int nthreads);
+RcppExport SEXP _NPDS4Clib_hu_ratio_reciprocal_cpp(SEXP sub_imageSEXP, SEXP split_sizeSEXP, SEXP image_sizeSEXP, SEXP nthreadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type sub_image(sub_imageSEXP);
+    Rcpp::traits::input_parameter< int >::type split_size(split_sizeSEXP);
+    Rcpp::traits::input_parameter< int >::type image_size(image_sizeSEXP);
+    Rcpp::traits::input_parameter< int >::type nthreads(nthreadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(hu_ratio_reciprocal_cpp(sub_image, split_size, image_size, nthreads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// npds_batch_cpp
+List npds_batch_cpp(SEXP bf_sub_image, SEXP af_sub_image, NumericVector bf_reciprocal, NumericVector af_reciprocal, NumericMatrix voxel_coords, int split_size, int image_size, NumericVector detection_lambda, int nthreads, SEXP workspace);
+RcppExport SEXP _NPDS4Clib_npds_batch_cpp(SEXP bf_sub_imageSEXP, SEXP af_sub_imageSEXP, SEXP bf_reciprocalSEXP, SEXP af_reciprocalSEXP, SEXP voxel_coordsSEXP, SEXP split_sizeSEXP, SEXP image_sizeSEXP, SEXP detection_lambdaSEXP, SEXP nthreadsSEXP, SEXP workspaceSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type bf_sub_image(bf_sub_imageSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type af_sub_image(af_sub_imageSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type bf_reciprocal(bf_reciprocalSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type af_reciprocal(af_reciprocalSEXP);
+    Rcpp::traits::input_parameter< NumericMatrix >::type voxel_coords(voxel_coordsSEXP);
+    Rcpp::traits::input_parameter< int >::type split_size(split_sizeSEXP);
+    Rcpp::traits::input_parameter< int >::type image_size(image_sizeSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type detection_lambda(detection_lambdaSEXP);
+    Rcpp::traits::input_parameter< int >::type nthreads(nthreadsSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type workspace(workspaceSEXP);
+    rcpp_result_gen = Rcpp::wrap(npds_batch_cpp(bf_sub_image, af_sub_image, bf_reciprocal, af_reciprocal, voxel_coords, split_size, image_size, detection_lambda, nthreads, workspace));
+    return rcpp_result_gen;
+END_RCPP
+}
+// npds_calculate_cpp
+List npds_calculate_cpp(SEXP bf_sub_image, SEXP af_sub_image, NumericVector voxel_coord, int split_size, int image_size, NumericVector detection_lambda, int nthreads, bool profile, SEXP workspace, SEXP bf_mask, SEXP af_mask, double min_coverage);
+RcppExport SEXP _NPDS4Clib_npds_calculate_cpp(SEXP bf_sub_imageSEXP, SEXP af_sub_imageSEXP, SEXP voxel_coordSEXP, SEXP split_sizeSEXP, SEXP image_sizeSEXP, SEXP detection_lambdaSEXP, SEXP nthreadsSEXP, SEXP profileSEXP, SEXP workspaceSEXP, SEXP bf_maskSEXP, SEXP af_maskSEXP, SEXP min_coverageSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type bf_sub_image(bf_sub_imageSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type af_sub_image(af_sub_imageSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type voxel_coord(voxel_coordSEXP);
+    Rcpp::traits::input_parameter< int >::type split_size(split_sizeSEXP);
+    Rcpp::traits::input_parameter< int >::type image_size(image_sizeSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type detection_lambda(detection_lambdaSEXP);
+    Rcpp::traits::input_parameter< int >::type nthreads(nthreadsSEXP);
+    Rcpp::traits::input_parameter< bool >::type profile(profileSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type workspace(workspaceSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type bf_mask(bf_maskSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type af_mask(af_maskSEXP);
+    Rcpp::traits::input_parameter< double >::type min_coverage(min_coverageSEXP);
+    rcpp_result_gen = Rcpp::wrap(npds_calculate_cpp(bf_sub_image, af_sub_image, voxel_coord, split_size, image_size, detection_lambda, nthreads, profile, workspace, bf_mask, af_mask, min_coverage));
+    return rcpp_result_gen;
+END_RCPP
+}
+// npds_heatmap_cpp
+List npds_heatmap_cpp(SEXP bf_sub_image, SEXP af_sub_image, NumericVector bf_reciprocal, NumericVector af_reciprocal, NumericVector voxel_coord, int radius, int split_size, int image_size, NumericVector detection_lambda, int nthreads, SEXP workspace);
+RcppExport SEXP _NPDS4Clib_npds_heatmap_cpp(SEXP bf_sub_imageSEXP, SEXP af_sub_imageSEXP, SEXP bf_reciprocalSEXP, SEXP af_reciprocalSEXP, SEXP voxel_coordSEXP, SEXP radiusSEXP, SEXP split_sizeSEXP, SEXP image_sizeSEXP, SEXP detection_lambdaSEXP, SEXP nthreadsSEXP, SEXP workspaceSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type bf_sub_image(bf_sub_imageSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type af_sub_image(af_sub_imageSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type bf_reciprocal(bf_reciprocalSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type af_reciprocal(af_reciprocalSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type voxel_coord(voxel_coordSEXP);
+    Rcpp::traits::input_parameter< int >::type radius(radiusSEXP);
+    Rcpp::traits::input_parameter< int >::type split_size(split_sizeSEXP);
+    Rcpp::traits::input_parameter< int >::type image_size(image_sizeSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type detection_lambda(detection_lambdaSEXP);
+    Rcpp::traits::input_parameter< int >::type nthreads(nthreadsSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type workspace(workspaceSEXP);
+    rcpp_result_gen = Rcpp::wrap(npds_heatmap_cpp(bf_sub_image, af_sub_image, bf_reciprocal, af_reciprocal, voxel_coord, radius, split_size, image_size, detection_lambda, nthreads, workspace));
+    return rcpp_result_gen;
+END_RCPP
+}
+// npds_workspace_cpp
+SEXP npds_workspace_cpp(int image_size, int split_size, int nthreads, int n_slices, int radius, int R);
+RcppExport SEXP _NPDS4Clib_npds_workspace_cpp(SEXP image_sizeSEXP, SEXP split_sizeSEXP, SEXP nthreadsSEXP, SEXP n_slicesSEXP, SEXP radiusSEXP, SEXP RSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< int >::type image_size(image_sizeSEXP);
+    Rcpp::traits::input_parameter< int >::type split_size(split_sizeSEXP);
+    Rcpp::traits::input_parameter< int >::type nthreads(nthreadsSEXP);
+    Rcpp::traits::input_parameter< int >::type n_slices(n_slicesSEXP);
+    Rcpp::traits::input_parameter< int >::type radius(radiusSEXP);
+    Rcpp::traits::input_parameter< int >::type R(RSEXP);
+    rcpp_result_gen = Rcpp::wrap(npds_workspace_cpp(image_size, split_size, nthreads, n_slices, radius, R));
+    return rcpp_result_gen;
+END_RCPP
+}
 // process_lung_regions
-List process_lung_regions(IntegerMatrix label_image, IntegerMatrix regions);
-RcppExport SEXP _NPDS4Clib_process_lung_regions(SEXP label_imageSEXP, SEXP regionsSEXP) {
+List process_lung_regions(IntegerMatrix label_image, DataFrame regions, int top_k, int min_area, int max_extent, bool binary_mask, bool drop_border);
+RcppExport SEXP _NPDS4Clib_process_lung_regions(SEXP label_imageSEXP, SEXP regionsSEXP, SEXP top_kSEXP, SEXP min_areaSEXP, SEXP max_extentSEXP, SEXP binary_maskSEXP, SEXP drop_borderSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< IntegerMatrix >::type label_image(label_imageSEXP);
-    Rcpp::traits::input_parameter< IntegerMatrix >::type regions(regionsSEXP);
-    rcpp_result_gen = Rcpp::wrap(process_lung_regions(label_image, regions));
+    Rcpp::traits::input_parameter< DataFrame >::type regions(regionsSEXP);
+    Rcpp::traits::input_parameter< int >::type top_k(top_kSEXP);
+    Rcpp::traits::input_parameter< int >::type min_area(min_areaSEXP);
+    Rcpp::traits::input_parameter< int >::type max_extent(max_extentSEXP);
+    Rcpp::traits::input_parameter< bool >::type binary_mask(binary_maskSEXP);
+    Rcpp::traits::input_parameter< bool >::type drop_border(drop_borderSEXP);
+    rcpp_result_gen = Rcpp::wrap(process_lung_regions(label_image, regions, top_k, min_area, max_extent, binary_mask, drop_border));
+    return rcpp_result_gen;
+END_RCPP
+}
+// read_nifti_header_cpp
+List read_nifti_header_cpp(std::string path);
+RcppExport SEXP _NPDS4Clib_read_nifti_header_cpp(SEXP pathSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type path(pathSEXP);
+    rcpp_result_gen = Rcpp::wrap(read_nifti_header_cpp(path));
+    return rcpp_result_gen;
+END_RCPP
+}
+// read_nifti_slab_cpp
+List read_nifti_slab_cpp(std::string path, int z_first, int z_last, std::string storage, std::string layout);
+RcppExport SEXP _NPDS4Clib_read_nifti_slab_cpp(SEXP pathSEXP, SEXP z_firstSEXP, SEXP z_lastSEXP, SEXP storageSEXP, SEXP layoutSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type path(pathSEXP);
+    Rcpp::traits::input_parameter< int >::type z_first(z_firstSEXP);
+    Rcpp::traits::input_parameter< int >::type z_last(z_lastSEXP);
+    Rcpp::traits::input_parameter< std::string >::type storage(storageSEXP);
+    Rcpp::traits::input_parameter< std::string >::type layout(layoutSEXP);
+    rcpp_result_gen = Rcpp::wrap(read_nifti_slab_cpp(path, z_first, z_last, storage, layout));
     return rcpp_result_gen;
 END_RCPP
 }
@@ -171,6 +436,132 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// regionprops_cpp
+DataFrame regionprops_cpp(List input, int buffer_size);
+RcppExport SEXP _NPDS4Clib_regionprops_cpp(SEXP inputSEXP, SEXP buffer_sizeSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< List >::type input(inputSEXP);
+    Rcpp::traits::input_parameter< int >::type buffer_size(buffer_sizeSEXP);
+    rcpp_result_gen = Rcpp::wrap(regionprops_cpp(input, buffer_size));
+    return rcpp_result_gen;
+END_RCPP
+}
+// rigid_metric_cpp
+double rigid_metric_cpp(SEXP target, SEXP source, NumericVector params, NumericVector center, NumericVector target_spacing, NumericVector source_spacing, NumericVector target_orientation, NumericVector source_orientation, int z_first, int z_last, int step, int nthreads);
+RcppExport SEXP _NPDS4Clib_rigid_metric_cpp(SEXP targetSEXP, SEXP sourceSEXP, SEXP paramsSEXP, SEXP centerSEXP, SEXP target_spacingSEXP, SEXP source_spacingSEXP, SEXP target_orientationSEXP, SEXP source_orientationSEXP, SEXP z_firstSEXP, SEXP z_lastSEXP, SEXP stepSEXP, SEXP nthreadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type target(targetSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type source(sourceSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type params(paramsSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type center(centerSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type target_spacing(target_spacingSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type source_spacing(source_spacingSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type target_orientation(target_orientationSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type source_orientation(source_orientationSEXP);
+    Rcpp::traits::input_parameter< int >::type z_first(z_firstSEXP);
+    Rcpp::traits::input_parameter< int >::type z_last(z_lastSEXP);
+    Rcpp::traits::input_parameter< int >::type step(stepSEXP);
+    Rcpp::traits::input_parameter< int >::type nthreads(nthreadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(rigid_metric_cpp(target, source, params, center, target_spacing, source_spacing, target_orientation, source_orientation, z_first, z_last, step, nthreads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// rigid_resample_cpp
+SEXP rigid_resample_cpp(SEXP target, SEXP source, NumericVector params, NumericVector center, NumericVector target_spacing, NumericVector source_spacing, NumericVector target_orientation, NumericVector source_orientation, int z_first, int z_last, int nthreads);
+RcppExport SEXP _NPDS4Clib_rigid_resample_cpp(SEXP targetSEXP, SEXP sourceSEXP, SEXP paramsSEXP, SEXP centerSEXP, SEXP target_spacingSEXP, SEXP source_spacingSEXP, SEXP target_orientationSEXP, SEXP source_orientationSEXP, SEXP z_firstSEXP, SEXP z_lastSEXP, SEXP nthreadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type target(targetSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type source(sourceSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type params(paramsSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type center(centerSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type target_spacing(target_spacingSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type source_spacing(source_spacingSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type target_orientation(target_orientationSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type source_orientation(source_orientationSEXP);
+    Rcpp::traits::input_parameter< int >::type z_first(z_firstSEXP);
+    Rcpp::traits::input_parameter< int >::type z_last(z_lastSEXP);
+    Rcpp::traits::input_parameter< int >::type nthreads(nthreadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(rigid_resample_cpp(target, source, params, center, target_spacing, source_spacing, target_orientation, source_orientation, z_first, z_last, nthreads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// segment_lung_slice_cpp
+List segment_lung_slice_cpp(NumericMatrix im, double threshold, int buffer_size, int connectivity, int top_k, int min_area, int max_extent, SEXP workspace);
+RcppExport SEXP _NPDS4Clib_segment_lung_slice_cpp(SEXP imSEXP, SEXP thresholdSEXP, SEXP buffer_sizeSEXP, SEXP connectivitySEXP, SEXP top_kSEXP, SEXP min_areaSEXP, SEXP max_extentSEXP, SEXP workspaceSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericMatrix >::type im(imSEXP);
+    Rcpp::traits::input_parameter< double >::type threshold(thresholdSEXP);
+    Rcpp::traits::input_parameter< int >::type buffer_size(buffer_sizeSEXP);
+    Rcpp::traits::input_parameter< int >::type connectivity(connectivitySEXP);
+    Rcpp::traits::input_parameter< int >::type top_k(top_kSEXP);
+    Rcpp::traits::input_parameter< int >::type min_area(min_areaSEXP);
+    Rcpp::traits::input_parameter< int >::type max_extent(max_extentSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type workspace(workspaceSEXP);
+    rcpp_result_gen = Rcpp::wrap(segment_lung_slice_cpp(im, threshold, buffer_size, connectivity, top_k, min_area, max_extent, workspace));
+    return rcpp_result_gen;
+END_RCPP
+}
+// bwlabel3d
+List bwlabel3d(NumericVector x, int connectivity);
+RcppExport SEXP _NPDS4Clib_bwlabel3d(SEXP xSEXP, SEXP connectivitySEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericVector >::type x(xSEXP);
+    Rcpp::traits::input_parameter< int >::type connectivity(connectivitySEXP);
+    rcpp_result_gen = Rcpp::wrap(bwlabel3d(x, connectivity));
+    return rcpp_result_gen;
+END_RCPP
+}
+// segment_lungs_volume3d_cpp
+List segment_lungs_volume3d_cpp(SEXP bf_sub_image, SEXP af_sub_image, int nthreads, double threshold, int buffer_size, int connectivity, int top_k, int min_voxels, int max_extent, bool clear_z_border, SEXP workspace);
+RcppExport SEXP _NPDS4Clib_segment_lungs_volume3d_cpp(SEXP bf_sub_imageSEXP, SEXP af_sub_imageSEXP, SEXP nthreadsSEXP, SEXP thresholdSEXP, SEXP buffer_sizeSEXP, SEXP connectivitySEXP, SEXP top_kSEXP, SEXP min_voxelsSEXP, SEXP max_extentSEXP, SEXP clear_z_borderSEXP, SEXP workspaceSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type bf_sub_image(bf_sub_imageSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type af_sub_image(af_sub_imageSEXP);
+    Rcpp::traits::input_parameter< int >::type nthreads(nthreadsSEXP);
+    Rcpp::traits::input_parameter< double >::type threshold(thresholdSEXP);
+    Rcpp::traits::input_parameter< int >::type buffer_size(buffer_sizeSEXP);
+    Rcpp::traits::input_parameter< int >::type connectivity(connectivitySEXP);
+    Rcpp::traits::input_parameter< int >::type top_k(top_kSEXP);
+    Rcpp::traits::input_parameter< int >::type min_voxels(min_voxelsSEXP);
+    Rcpp::traits::input_parameter< int >::type max_extent(max_extentSEXP);
+    Rcpp::traits::input_parameter< bool >::type clear_z_border(clear_z_borderSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type workspace(workspaceSEXP);
+    rcpp_result_gen = Rcpp::wrap(segment_lungs_volume3d_cpp(bf_sub_image, af_sub_image, nthreads, threshold, buffer_size, connectivity, top_k, min_voxels, max_extent, clear_z_border, workspace));
+    return rcpp_result_gen;
+END_RCPP
+}
+// segment_lungs_volume_cpp
+List segment_lungs_volume_cpp(SEXP bf_sub_image, SEXP af_sub_image, int nthreads, double threshold, int buffer_size, int connectivity, int top_k, int min_area, int max_extent, SEXP workspace);
+RcppExport SEXP _NPDS4Clib_segment_lungs_volume_cpp(SEXP bf_sub_imageSEXP, SEXP af_sub_imageSEXP, SEXP nthreadsSEXP, SEXP thresholdSEXP, SEXP buffer_sizeSEXP, SEXP connectivitySEXP, SEXP top_kSEXP, SEXP min_areaSEXP, SEXP max_extentSEXP, SEXP workspaceSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type bf_sub_image(bf_sub_imageSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type af_sub_image(af_sub_imageSEXP);
+    Rcpp::traits::input_parameter< int >::type nthreads(nthreadsSEXP);
+    Rcpp::traits::input_parameter< double >::type threshold(thresholdSEXP);
+    Rcpp::traits::input_parameter< int >::type buffer_size(buffer_sizeSEXP);
+    Rcpp::traits::input_parameter< int >::type connectivity(connectivitySEXP);
+    Rcpp::traits::input_parameter< int >::type top_k(top_kSEXP);
+    Rcpp::traits::input_parameter< int >::type min_area(min_areaSEXP);
+    Rcpp::traits::input_parameter< int >::type max_extent(max_extentSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type workspace(workspaceSEXP);
+    rcpp_result_gen = Rcpp::wrap(segment_lungs_volume_cpp(bf_sub_image, af_sub_image, nthreads, threshold, buffer_size, connectivity, top_k, min_area, max_extent, workspace));
+    return rcpp_result_gen;
+END_RCPP
+}
 // trapz_rcpp
 double trapz_rcpp(NumericVector x, NumericVector y);
 RcppExport SEXP _NPDS4Clib_trapz_rcpp(SEXP xSEXP, SEXP ySEXP) {
@@ -183,21 +574,98 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// encode_volume_cpp
+SEXP encode_volume_cpp(NumericVector x, std::string storage);
+RcppExport SEXP _NPDS4Clib_encode_volume_cpp(SEXP xSEXP, SEXP storageSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericVector >::type x(xSEXP);
+    Rcpp::traits::input_parameter< std::string >::type storage(storageSEXP);
+    rcpp_result_gen = Rcpp::wrap(encode_volume_cpp(x, storage));
+    return rcpp_result_gen;
+END_RCPP
+}
+// encode_nifti_cpp
+SEXP encode_nifti_cpp(NumericVector x, std::string storage, std::string layout);
+RcppExport SEXP _NPDS4Clib_encode_nifti_cpp(SEXP xSEXP, SEXP storageSEXP, SEXP layoutSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericVector >::type x(xSEXP);
+    Rcpp::traits::input_parameter< std::string >::type storage(storageSEXP);
+    Rcpp::traits::input_parameter< std::string >::type layout(layoutSEXP);
+    rcpp_result_gen = Rcpp::wrap(encode_nifti_cpp(x, storage, layout));
+    return rcpp_result_gen;
+END_RCPP
+}
+// decode_volume_cpp
+NumericVector decode_volume_cpp(SEXP x);
+RcppExport SEXP _NPDS4Clib_decode_volume_cpp(SEXP xSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type x(xSEXP);
+    rcpp_result_gen = Rcpp::wrap(decode_volume_cpp(x));
+    return rcpp_result_gen;
+END_RCPP
+}
+// subset_slices_cpp
+SEXP subset_slices_cpp(SEXP x, int first, int last);
+RcppExport SEXP _NPDS4Clib_subset_slices_cpp(SEXP xSEXP, SEXP firstSEXP, SEXP lastSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type x(xSEXP);
+    Rcpp::traits::input_parameter< int >::type first(firstSEXP);
+    Rcpp::traits::input_parameter< int >::type last(lastSEXP);
+    rcpp_result_gen = Rcpp::wrap(subset_slices_cpp(x, first, last));
+    return rcpp_result_gen;
+END_RCPP
+}
 
 static const R_CallMethodDef CallEntries[] = {
-    {"_NPDS4Clib_HU_ratio_nodule_progression_detection_slice_cpp", (DL_FUNC) &_NPDS4Clib_HU_ratio_nodule_progression_detection_slice_cpp, 8},
-    {"_NPDS4Clib_bwlabel", (DL_FUNC) &_NPDS4Clib_bwlabel, 1},
+    {"_NPDS4Clib_HU_ratio_nodule_progression_detection_cpp", (DL_FUNC) &_NPDS4Clib_HU_ratio_nodule_progression_detection_cpp, 10},
+    {"_NPDS4Clib_HU_ratio_nodule_progression_detection_slice_cpp", (DL_FUNC) &_NPDS4Clib_HU_ratio_nodule_progression_detection_slice_cpp, 10},
+    {"_NPDS4Clib_HU_ratio_nodule_progression_detection_volume_cpp", (DL_FUNC) &_NPDS4Clib_HU_ratio_nodule_progression_detection_volume_cpp, 10},
+    {"_NPDS4Clib_bwlabel", (DL_FUNC) &_NPDS4Clib_bwlabel, 2},
     {"_NPDS4Clib_get_border_indices", (DL_FUNC) &_NPDS4Clib_get_border_indices, 2},
     {"_NPDS4Clib_create_label_mask", (DL_FUNC) &_NPDS4Clib_create_label_mask, 2},
     {"_NPDS4Clib_create_clear_mask", (DL_FUNC) &_NPDS4Clib_create_clear_mask, 2},
     {"_NPDS4Clib_clear_border_pixels", (DL_FUNC) &_NPDS4Clib_clear_border_pixels, 3},
-    {"_NPDS4Clib_clear_border", (DL_FUNC) &_NPDS4Clib_clear_border, 3},
+    {"_NPDS4Clib_clear_border", (DL_FUNC) &_NPDS4Clib_clear_border, 5},
+    {"_NPDS4Clib_read_sorted_column_cpp", (DL_FUNC) &_NPDS4Clib_read_sorted_column_cpp, 2},
+    {"_NPDS4Clib_sorted_exceedance_cpp", (DL_FUNC) &_NPDS4Clib_sorted_exceedance_cpp, 2},
+    {"_NPDS4Clib_clinv_group_cpp", (DL_FUNC) &_NPDS4Clib_clinv_group_cpp, 1},
+    {"_NPDS4Clib_hypothesis_test_cpp", (DL_FUNC) &_NPDS4Clib_hypothesis_test_cpp, 4},
+    {"_NPDS4Clib_content_hash_cpp", (DL_FUNC) &_NPDS4Clib_content_hash_cpp, 2},
+    {"_NPDS4Clib_volume_hash_cpp", (DL_FUNC) &_NPDS4Clib_volume_hash_cpp, 1},
+    {"_NPDS4Clib_pack_detection_matrix_cpp", (DL_FUNC) &_NPDS4Clib_pack_detection_matrix_cpp, 2},
+    {"_NPDS4Clib_expand_detection_matrix_cpp", (DL_FUNC) &_NPDS4Clib_expand_detection_matrix_cpp, 2},
     {"_NPDS4Clib_generate_lung_tissue_blocks_slice_cpp", (DL_FUNC) &_NPDS4Clib_generate_lung_tissue_blocks_slice_cpp, 3},
     {"_NPDS4Clib_generate_nodule_block_list_slice_cpp", (DL_FUNC) &_NPDS4Clib_generate_nodule_block_list_slice_cpp, 7},
     {"_NPDS4Clib_generate_nodule_block_list_slice_cpp_v2", (DL_FUNC) &_NPDS4Clib_generate_nodule_block_list_slice_cpp_v2, 7},
-    {"_NPDS4Clib_process_lung_regions", (DL_FUNC) &_NPDS4Clib_process_lung_regions, 2},
+    {"_NPDS4Clib_hu_ratio_reciprocal_cpp", (DL_FUNC) &_NPDS4Clib_hu_ratio_reciprocal_cpp, 4},
+    {"_NPDS4Clib_npds_batch_cpp", (DL_FUNC) &_NPDS4Clib_npds_batch_cpp, 10},
+    {"_NPDS4Clib_npds_calculate_cpp", (DL_FUNC) &_NPDS4Clib_npds_calculate_cpp, 12},
+    {"_NPDS4Clib_npds_heatmap_cpp", (DL_FUNC) &_NPDS4Clib_npds_heatmap_cpp, 11},
+    {"_NPDS4Clib_npds_workspace_cpp", (DL_FUNC) &_NPDS4Clib_npds_workspace_cpp, 6},
+    {"_NPDS4Clib_process_lung_regions", (DL_FUNC) &_NPDS4Clib_process_lung_regions, 7},
+    {"_NPDS4Clib_read_nifti_header_cpp", (DL_FUNC) &_NPDS4Clib_read_nifti_header_cpp, 1},
+    {"_NPDS4Clib_read_nifti_slab_cpp", (DL_FUNC) &_NPDS4Clib_read_nifti_slab_cpp, 5},
     {"_NPDS4Clib_regionprops_bbox", (DL_FUNC) &_NPDS4Clib_regionprops_bbox, 1},
+    {"_NPDS4Clib_regionprops_cpp", (DL_FUNC) &_NPDS4Clib_regionprops_cpp, 2},
+    {"_NPDS4Clib_rigid_metric_cpp", (DL_FUNC) &_NPDS4Clib_rigid_metric_cpp, 12},
+    {"_NPDS4Clib_rigid_resample_cpp", (DL_FUNC) &_NPDS4Clib_rigid_resample_cpp, 11},
+    {"_NPDS4Clib_segment_lung_slice_cpp", (DL_FUNC) &_NPDS4Clib_segment_lung_slice_cpp, 8},
+    {"_NPDS4Clib_bwlabel3d", (DL_FUNC) &_NPDS4Clib_bwlabel3d, 2},
+    {"_NPDS4Clib_segment_lungs_volume3d_cpp", (DL_FUNC) &_NPDS4Clib_segment_lungs_volume3d_cpp, 11},
+    {"_NPDS4Clib_segment_lungs_volume_cpp", (DL_FUNC) &_NPDS4Clib_segment_lungs_volume_cpp, 10},
     {"_NPDS4Clib_trapz_rcpp", (DL_FUNC) &_NPDS4Clib_trapz_rcpp, 2},
+    {"_NPDS4Clib_encode_volume_cpp", (DL_FUNC) &_NPDS4Clib_encode_volume_cpp, 2},
+    {"_NPDS4Clib_encode_nifti_cpp", (DL_FUNC) &_NPDS4Clib_encode_nifti_cpp, 3},
+    {"_NPDS4Clib_decode_volume_cpp", (DL_FUNC) &_NPDS4Clib_decode_volume_cpp, 1},
+    {"_NPDS4Clib_subset_slices_cpp", (DL_FUNC) &_NPDS4Clib_subset_slices_cpp, 3},
     {NULL, NULL, 0}
 };
 
@@ -0,0 +1,300 @@
+#ifndef NPDS4CLIB_BITMASK_H
+#define NPDS4CLIB_BITMASK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "bwlabel.h"
+
+// 按位打包的二值掩膜：每个 64 位字存放同一列上连续的 64 个像素
+// 与 R 矩阵一样按列优先：第 j 列占 words 个字，像素 (i, j) 为 bits[j * words + i / 64] 的第 i % 64 位
+// 每列最后一个字中超出 nrow 的位恒为 0
+// 阈值化、掩膜的与 / 或 / 非、清除与边界相连的区域都按字并行处理，工作集是 double 矩阵的 1/64
+struct BitMask {
+  int nrow, ncol, words;
+  std::vector<uint64_t> bits;
+
+  BitMask() : nrow(0), ncol(0), words(0) {}
+
+  // 调整为 nrow x ncol 并清零；容量足够时不重新分配
+  void resize(int nrow_, int ncol_) {
+    nrow = nrow_;
+    ncol = ncol_;
+    words = (nrow + 63) / 64;
+    bits.assign(static_cast<std::size_t>(words) * ncol, 0);
+  }
+
+  uint64_t *column(int j) { return bits.data() + static_cast<std::ptrdiff_t>(j) * words; }
+  const uint64_t *column(int j) const { return bits.data() + static_cast<std::ptrdiff_t>(j) * words; }
+
+  bool get(int i, int j) const { return (column(j)[i >> 6] >> (i & 63)) & 1; }
+
+  // 一列中第 w 个字的有效位
+  uint64_t valid(int w) const {
+    int rest = nrow - 64 * w;
+    return rest >= 64 ? ~uint64_t(0) : ((uint64_t(1) << rest) - 1);
+  }
+};
+
+// 字中最低的置位的位置；word 不为 0
+inline int _bit_ctz(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_ctzll(word);
+#else
+  int n = 0;
+  while (!(word & 1)) {
+    word >>= 1;
+    n++;
+  }
+  return n;
+#endif
+}
+
+// 阈值化：im(i, j) < threshold 的像素置 1（NaN 不小于阈值，为 0）
+// (i, j) 像素位于 im[i * row_stride + j * col_stride]，与 _segment_lung_slice 相同
+// 每次比较 64 个像素拼成一个字；读取输入切片是主要开销
+template <class T>
+inline void _bitmask_threshold(const T *im, XYPoint size, std::ptrdiff_t row_stride, std::ptrdiff_t col_stride,
+                               double threshold, BitMask &out) {
+  out.resize(size.x, size.y);
+  for (int j = 0; j < out.ncol; j++) {
+    const T *col = im + j * col_stride;
+    uint64_t *dst = out.column(j);
+    for (int w = 0; w < out.words; w++) {
+      int i0 = 64 * w;
+      int n = out.nrow - i0 < 64 ? out.nrow - i0 : 64;
+      uint64_t word = 0;
+      if (row_stride == 1) {
+        // 单个矩阵的一列连续存放
+        const T *src = col + i0;
+        for (int b = 0; b < n; b++) word |= static_cast<uint64_t>(src[b] < threshold) << b;
+      } else {
+        for (int b = 0; b < n; b++) word |= static_cast<uint64_t>(col[(i0 + b) * row_stride] < threshold) << b;
+      }
+      dst[w] = word;
+    }
+  }
+}
+
+// 非零像素置 1，与 _bwlabel 的前景定义相同（NaN 也是前景）；x 为列优先的 nrow x ncol 矩阵
+template <class T>
+inline void _bitmask_nonzero(const T *x, XYPoint size, BitMask &out) {
+  out.resize(size.x, size.y);
+  for (int j = 0; j < out.ncol; j++) {
+    const T *col = x + static_cast<std::ptrdiff_t>(j) * out.nrow;
+    uint64_t *dst = out.column(j);
+    for (int w = 0; w < out.words; w++) {
+      int i0 = 64 * w;
+      int n = out.nrow - i0 < 64 ? out.nrow - i0 : 64;
+      uint64_t word = 0;
+      for (int b = 0; b < n; b++) word |= static_cast<uint64_t>(!(col[i0 + b] == T(0))) << b;
+      dst[w] = word;
+    }
+  }
+}
+
+// 掩膜运算，out 可以与 a、b 相同；a、b 的大小必须相同
+inline void _bitmask_and(const BitMask &a, const BitMask &b, BitMask &out) {
+  if (&out != &a) out = a;
+  for (std::size_t k = 0; k < out.bits.size(); k++) out.bits[k] &= b.bits[k];
+}
+
+inline void _bitmask_or(const BitMask &a, const BitMask &b, BitMask &out) {
+  if (&out != &a) out = a;
+  for (std::size_t k = 0; k < out.bits.size(); k++) out.bits[k] |= b.bits[k];
+}
+
+// a 且非 b
+inline void _bitmask_andnot(const BitMask &a, const BitMask &b, BitMask &out) {
+  if (&out != &a) out = a;
+  for (std::size_t k = 0; k < out.bits.size(); k++) out.bits[k] &= ~b.bits[k];
+}
+
+// 取反，超出 nrow 的位保持为 0
+inline void _bitmask_not(const BitMask &a, BitMask &out) {
+  if (&out != &a) out = a;
+  for (int j = 0; j < out.ncol; j++) {
+    uint64_t *col = out.column(j);
+    for (int w = 0; w < out.words; w++) col[w] = ~col[w] & out.valid(w);
+  }
+}
+
+// 置位的像素数
+inline std::size_t _bitmask_count(const BitMask &a) {
+  std::size_t n = 0;
+  for (std::size_t k = 0; k < a.bits.size(); k++) {
+#if defined(__GNUC__) || defined(__clang__)
+    n += __builtin_popcountll(a.bits[k]);
+#else
+    for (uint64_t word = a.bits[k]; word; word &= word - 1) n++;
+#endif
+  }
+  return n;
+}
+
+// 距图像边界 ext 个像素以内的边框，与 _regionprops 中 on_border 的范围相同
+// 边框内的整列按字写出，其余列只设置首尾各 ext 行
+inline void _bitmask_frame(int nrow, int ncol, int ext, BitMask &out) {
+  out.resize(nrow, ncol);
+  for (int j = 0; j < ncol; j++) {
+    uint64_t *col = out.column(j);
+    if ((j < ext) || (j >= ncol - ext) || 2 * ext >= nrow) {
+      for (int w = 0; w < out.words; w++) col[w] = out.valid(w);
+      continue;
+    }
+    for (int i = 0; i < ext; i++) {
+      col[i >> 6] |= uint64_t(1) << (i & 63);
+      int k = nrow - 1 - i;
+      col[k >> 6] |= uint64_t(1) << (k & 63);
+    }
+  }
+}
+
+// 字内从 gen 出发、只经过 pro 中的位向高位（行号增大）/ 低位扩展，Kogge-Stone 式的 6 步并行前缀
+inline uint64_t _bit_fill_up(uint64_t gen, uint64_t pro) {
+  gen |= pro & (gen << 1);
+  pro &= pro << 1;
+  gen |= pro & (gen << 2);
+  pro &= pro << 2;
+  gen |= pro & (gen << 4);
+  pro &= pro << 4;
+  gen |= pro & (gen << 8);
+  pro &= pro << 8;
+  gen |= pro & (gen << 16);
+  pro &= pro << 16;
+  gen |= pro & (gen << 32);
+  return gen;
+}
+
+inline uint64_t _bit_fill_down(uint64_t gen, uint64_t pro) {
+  gen |= pro & (gen >> 1);
+  pro &= pro >> 1;
+  gen |= pro & (gen >> 2);
+  pro &= pro >> 2;
+  gen |= pro & (gen >> 4);
+  pro &= pro >> 4;
+  gen |= pro & (gen >> 8);
+  pro &= pro >> 8;
+  gen |= pro & (gen >> 16);
+  pro &= pro >> 16;
+  gen |= pro & (gen >> 32);
+  return gen;
+}
+
+// 一列中 seed（须在 fg 之内）沿列方向扩展为它所在的前景整段：先自上而下、再自下而上各扫一遍，
+// 跨字的段由相邻字的最高位 / 最低位传递；返回 seed 是否有变化
+inline bool _bitmask_fill_column(const uint64_t *fg, uint64_t *seed, int words) {
+  bool changed = false;
+  uint64_t carry = 0;
+  for (int w = 0; w < words; w++) {
+    uint64_t g = _bit_fill_up((seed[w] | carry) & fg[w], fg[w]);
+    changed |= g != seed[w];
+    seed[w] = g;
+    carry = g >> 63;
+  }
+  carry = 0;
+  for (int w = words - 1; w >= 0; w--) {
+    uint64_t g = _bit_fill_down((seed[w] | (carry << 63)) & fg[w], fg[w]);
+    changed |= g != seed[w];
+    seed[w] = g;
+    carry = g & 1;
+  }
+  return changed;
+}
+
+// 相邻列 nb 传递到本列的种子：4 连通为同一行，8 连通再加上下各一行（跨字时取相邻字的边界位）
+inline uint64_t _bit_neighbour(const uint64_t *nb, int w, int words, bool diag) {
+  uint64_t x = nb[w];
+  if (!diag) return x;
+  uint64_t d = x | (x << 1) | (x >> 1);
+  if (w > 0) d |= nb[w - 1] >> 63;
+  if (w < words - 1) d |= nb[w + 1] << 63;
+  return d;
+}
+
+// 形态学重建：seed 扩展为 fg 中与它连通（connectivity 为 4 或 8）的所有像素
+// 按列交替向右、向左扫描，每列先接收相邻列的种子，再沿列方向整段扩展，直到一整轮没有变化
+inline void _bitmask_reconstruct(const BitMask &fg, BitMask &seed, int connectivity) {
+  bool diag = (connectivity == 8);
+  int words = fg.words;
+  for (std::size_t k = 0; k < seed.bits.size(); k++) seed.bits[k] &= fg.bits[k];
+
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (int pass = 0; pass < 2; pass++) {
+      for (int t = 0; t < fg.ncol; t++) {
+        int j = pass == 0 ? t : fg.ncol - 1 - t;
+        int prev = pass == 0 ? j - 1 : j + 1;
+        const uint64_t *f = fg.column(j);
+        uint64_t *s = seed.column(j);
+        if (prev >= 0 && prev < fg.ncol) {
+          const uint64_t *nb = seed.column(prev);
+          for (int w = 0; w < words; w++) {
+            uint64_t g = s[w] | (f[w] & _bit_neighbour(nb, w, words, diag));
+            changed |= g != s[w];
+            s[w] = g;
+          }
+        }
+        changed |= _bitmask_fill_column(f, s, words);
+      }
+    }
+  }
+}
+
+// fg 中与边界（ext 个像素以内的边框）相连的连通区域，写入 border
+inline void _bitmask_border_regions(const BitMask &fg, int ext, int connectivity, BitMask &border) {
+  _bitmask_frame(fg.nrow, fg.ncol, ext, border);
+  _bitmask_reconstruct(fg, border, connectivity);
+}
+
+// 在掩膜上做连通区域标记，结果与 _bwlabel 对同一前景的结果相同
+// 连续的背景像素按字跳过：整字为 0 时一次写出 64 个背景标签
+inline int _bwlabel(const BitMask &src, int *res, int connectivity, BWLabelWork &work) {
+  int nx = src.nrow;
+  int ny = src.ncol;
+  bool diag = (connectivity == 8);
+
+  std::vector<int> &parent = work.parent;
+  parent.clear();
+  parent.reserve(64);
+  parent.push_back(0);
+
+  for (int ky = 0; ky < ny; ky++) {
+    const uint64_t *col = src.column(ky);
+    int *r = res + static_cast<std::ptrdiff_t>(ky) * nx;
+    int kx = 0;
+    while (kx < nx) {
+      uint64_t word = col[kx >> 6] >> (kx & 63);
+      if (!(word & 1)) {
+        // 背景：跳到本字中下一个前景像素或下一个字
+        int run = word ? _bit_ctz(word) : 64 - (kx & 63);
+        if (run > nx - kx) run = nx - kx;
+        for (int t = 0; t < run; t++) r[kx + t] = 0;
+        kx += run;
+        continue;
+      }
+
+      int label = 0;
+      if (kx > 0 && r[kx - 1] != 0) label = r[kx - 1];
+      if (ky > 0) {
+        const int *l = r - nx;
+        if (l[kx] != 0) label = label ? _uf_union(parent.data(), label, l[kx]) : l[kx];
+        if (diag) {
+          if (kx > 0 && l[kx - 1] != 0) label = label ? _uf_union(parent.data(), label, l[kx - 1]) : l[kx - 1];
+          if (kx < nx - 1 && l[kx + 1] != 0) label = label ? _uf_union(parent.data(), label, l[kx + 1]) : l[kx + 1];
+        }
+      }
+      if (label == 0) {
+        label = static_cast<int>(parent.size());
+        parent.push_back(label);
+      }
+      r[kx] = label;
+      kx++;
+    }
+  }
+
+  return _bwlabel_finalize(res, nx * ny, work);
+}
+
+#endif
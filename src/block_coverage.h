@@ -0,0 +1,52 @@
+#ifndef NPDS4CLIB_BLOCK_COVERAGE_H
+#define NPDS4CLIB_BLOCK_COVERAGE_H
+
+#include <cstddef>
+#include <cstdint>
+#include "block_view.h"
+
+// 肺掩膜感知的稀疏组织块评估
+// 肺外的组织块在分割后全为 0，HU 比值退化为 nodule / 0.1；按肺掩膜只保留覆盖率足够的组织块参与计算与检测
+// 第 m 张切片的第 b 个组织块在两期掩膜中的肺像素比例都不小于 min_coverage 时 active[m * block_num + b] = 1
+// min_coverage 为 0 时所有组织块都参与，结果与不使用掩膜时逐位相同
+// 掩膜可以是 logical 数组或 uint8 的紧凑存储，非零即为肺；按切片并行
+template <class T>
+inline void _block_coverage(const T *bf_mask, const T *af_mask, const VolumeLayout &volume,
+                            int split_size, int split_num, double min_coverage,
+                            uint8_t *active, int nthreads = 1) {
+  int block_num = split_num * split_num;
+  double required = min_coverage * split_size * split_size;
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(nthreads) schedule(static)
+#endif
+  for (int m = 0; m < volume.n_slices; m++) {
+    SliceView<T> slice[2] = {volume_slice(bf_mask, volume, m), volume_slice(af_mask, volume, m)};
+    for (int b = 0; b < block_num; b++) {
+      int count[2] = {0, 0};
+      for (int s = 0; s < 2; s++) {
+        BlockView<T> block = slice[s].tissue_block(b / split_num, b % split_num, split_size);
+        for (int l = 0; l < split_size; l++) {
+          for (int k = 0; k < split_size; k++) count[s] += block(k, l) != 0;
+        }
+      }
+      active[static_cast<std::ptrdiff_t>(m) * block_num + b] = count[0] >= required && count[1] >= required;
+    }
+  }
+}
+
+// 按掩膜的存储类型计算 active
+struct BlockCoverageTask {
+  VolumeLayout volume;
+  int split_size, split_num;
+  double min_coverage;
+  uint8_t *active;
+  int nthreads;
+
+  template <class T>
+  void operator()(const T *bf_mask, const T *af_mask) {
+    _block_coverage(bf_mask, af_mask, volume, split_size, split_num, min_coverage, active, nthreads);
+  }
+};
+
+#endif
@@ -0,0 +1,128 @@
+#ifndef NPDS4CLIB_BLOCK_VIEW_H
+#define NPDS4CLIB_BLOCK_VIEW_H
+
+#include <cstddef>
+
+// 块视图：从切片中某个左上角开始的 size x size 子块，不拷贝数据
+// (k, l) 像素位于 origin[k * row_stride + l * col_stride]，与 generate_lung_tissue_blocks_slice_cpp 中
+// 展平后的第 k * split_size + l 个像素对应
+template <class T>
+struct BlockView {
+  const T *origin;
+  std::ptrdiff_t row_stride, col_stride;
+  int size;
+
+  const T &operator()(int k, int l) const {
+    return origin[k * row_stride + l * col_stride];
+  }
+};
+
+// 切片视图：(i, j) 像素位于 data[i * row_stride + j * col_stride]
+// 对 R 矩阵 row_stride = 1、col_stride = nrow；对 [z, y, x] 体数据的第 m 张切片
+// data 指向第 m 个元素，row_stride = z 方向长度，col_stride = z 方向长度 * y 方向长度
+template <class T>
+struct SliceView {
+  const T *data;
+  int nrow, ncol;
+  std::ptrdiff_t row_stride, col_stride;
+
+  const T &operator()(int i, int j) const {
+    return data[i * row_stride + j * col_stride];
+  }
+
+  // 左上角为 (row0, col0) 的 size x size 子块
+  BlockView<T> block(int row0, int col0, int size) const {
+    BlockView<T> b = {data + row0 * row_stride + col0 * col_stride, row_stride, col_stride, size};
+    return b;
+  }
+
+  // 按 split_size 切分后第 (i, j) 个组织块，对应一维索引 i * split_num + j
+  BlockView<T> tissue_block(int i, int j, int split_size) const {
+    return block(i * split_size, j * split_size, split_size);
+  }
+};
+
+// 组织块的边长 split_size 与每行每列的分块数 split_num
+// S、N 不为 0 时两者为编译期常量：initialization 只会选择 32 或 64 的 split_size，image_size 几乎总是 512，
+// 对 BlockSize<32, 16> 与 BlockSize<64, 8>，块内下标的除法、取余变为移位，像素循环的次数固定，
+// 编译器可以完全展开、向量化并去掉边界判断；BlockSize<0, 0> 为通用版本，使用运行时的值
+template <int S, int N>
+struct BlockSize {
+  int runtime_split_size, runtime_split_num;
+
+  int split_size() const { return S ? S : runtime_split_size; }
+  int split_num() const { return N ? N : runtime_split_num; }
+  int block_num() const { return split_num() * split_num(); }
+  int n_pixels() const { return split_size() * split_size(); }
+};
+
+// 按 split_size、split_num 调用 f(BlockSize<S, N>)：(32, 16) 与 (64, 8) 即 image_size = 512 时
+// 使用特化版本，其余大小使用通用版本；f 为带模板 operator() 的函数对象，各版本的结果逐位相同
+template <class F>
+inline void dispatch_block_size(int split_size, int split_num, F &f) {
+  if (split_size == 32 && split_num == 16) {
+    BlockSize<32, 16> size = {32, 16};
+    f(size);
+  } else if (split_size == 64 && split_num == 8) {
+    BlockSize<64, 8> size = {64, 8};
+    f(size);
+  } else {
+    BlockSize<0, 0> size = {split_size, split_num};
+    f(size);
+  }
+}
+
+// 在按存储类型分派的函数对象中再按 BlockSize 分派：调用 f.run(a, b, size)
+template <class F, class T>
+struct BlockSizeCall {
+  F *f;
+  const T *a, *b;
+
+  template <int S, int N>
+  void operator()(const BlockSize<S, N> &size) {
+    f->run(a, b, size);
+  }
+};
+
+template <class F, class T>
+inline void dispatch_block_size(int split_size, int split_num, F &f, const T *a, const T *b) {
+  BlockSizeCall<F, T> call = {&f, a, b};
+  dispatch_block_size(split_size, split_num, call);
+}
+
+// 体数据的内存布局：第 m 张切片的 (i, j) 像素位于 data[m * slice_stride + i * row_stride + j * col_stride]
+// R 中转置后的 [z, y, x] 数组 z 变化最快；NIfTI 文件的原始顺序 [x, y, z] 为 x 变化最快
+struct VolumeLayout {
+  int n_slices, nrow, ncol;
+  std::ptrdiff_t slice_stride, row_stride, col_stride;
+};
+
+// [z, y, x] 布局，dims 为 (n_slices, nrow, ncol)
+inline VolumeLayout zyx_layout(int n_slices, int nrow, int ncol) {
+  VolumeLayout l = {n_slices, nrow, ncol, 1, static_cast<std::ptrdiff_t>(n_slices),
+                    static_cast<std::ptrdiff_t>(n_slices) * nrow};
+  return l;
+}
+
+// NIfTI 原始的 [x, y, z] 布局，dims 为 (ncol, nrow, n_slices)
+inline VolumeLayout xyz_layout(int n_slices, int nrow, int ncol) {
+  VolumeLayout l = {n_slices, nrow, ncol, static_cast<std::ptrdiff_t>(ncol) * nrow,
+                    static_cast<std::ptrdiff_t>(ncol), 1};
+  return l;
+}
+
+// 体数据中第 m 张切片的视图
+template <class T>
+inline SliceView<T> volume_slice(const T *volume, const VolumeLayout &layout, int m) {
+  SliceView<T> s = {volume + m * layout.slice_stride, layout.nrow, layout.ncol,
+                    layout.row_stride, layout.col_stride};
+  return s;
+}
+
+// [z, y, x] 体数据中第 m 张切片的视图
+template <class T>
+inline SliceView<T> volume_slice(const T *volume, int n_slices, int nrow, int ncol, int m) {
+  return volume_slice(volume, zyx_layout(n_slices, nrow, ncol), m);
+}
+
+#endif
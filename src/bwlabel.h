@@ -0,0 +1,130 @@
+#ifndef NPDS4CLIB_BWLABEL_H
+#define NPDS4CLIB_BWLABEL_H
+
+#include <vector>
+
+// 连通区域标记的公共实现，供 clear_border.cpp 与 segment_lung_slice_cpp.cpp 共用。
+// 采用两遍扫描 + 并查集，替代原先改编自 EBImage 的 flood fill：
+// 第一遍为每个前景像素分配临时标签并合并等价标签，第二遍把临时标签换成最终标签。
+// 最终标签按区域第一个像素的扫描顺序编号，与原 flood fill 的编号一致。
+
+struct XYPoint {
+  int x, y;
+  XYPoint() {}
+  XYPoint(int xx, int yy) : x(xx), y(yy) {}
+};
+
+// 查找根节点，同时做路径减半
+inline int _uf_find(int *parent, int a) {
+  while (parent[a] != a) {
+    parent[a] = parent[parent[a]];
+    a = parent[a];
+  }
+  return a;
+}
+
+// 合并两个等价类，始终以较小的标签作为根，保证根就是区域内最早出现的临时标签
+inline int _uf_union(int *parent, int a, int b) {
+  a = _uf_find(parent, a);
+  b = _uf_find(parent, b);
+  if (a < b) {
+    parent[b] = a;
+    return a;
+  }
+  parent[a] = b;
+  return b;
+}
+
+// 并查集与最终标签表，可在多张图像之间复用
+struct BWLabelWork {
+  std::vector<int> parent;
+  std::vector<int> final_label;
+};
+
+// 第一遍扫描之后：按临时标签的先后顺序给每个等价类分配连续的最终标签，
+// 再把 res 中 n 个像素的临时标签换成最终标签（第二遍），返回连通区域数量
+inline int _bwlabel_finalize(int *res, int n, BWLabelWork &work) {
+  std::vector<int> &parent = work.parent;
+  int n_provisional = static_cast<int>(parent.size());
+  std::vector<int> &final_label = work.final_label;
+  final_label.assign(n_provisional, 0);
+  int idx = 0;
+  for (int l = 1; l < n_provisional; l++) {
+    int root = _uf_find(parent.data(), l);
+    if (root == l) {
+      final_label[l] = ++idx;
+    } else {
+      final_label[l] = final_label[root];
+    }
+  }
+
+  for (int i = 0; i < n; i++) {
+    res[i] = final_label[res[i]];
+  }
+
+  return idx;
+}
+
+// _bwlabel 模板函数
+// src 中非零像素为前景（精确比较，不使用浮点容差），res 输出标签，背景为 0
+// size.x 为列优先存储中变化最快的维度（矩阵的行数）；connectivity 取 4 或 8
+// src 与 res 可以指向同一块内存（T 为 int 时原地标记）
+// work 为并查集的工作区
+template <class T>
+int _bwlabel(const T *src, int *res, XYPoint size, int connectivity, BWLabelWork &work) {
+  int nx = size.x;
+  int ny = size.y;
+  bool diag = (connectivity == 8);
+
+  // parent[0] 保留给背景
+  std::vector<int> &parent = work.parent;
+  parent.clear();
+  parent.reserve(64);
+  parent.push_back(0);
+
+  // 第一遍：分配临时标签并记录等价关系
+  int pos = 0;
+  for (int ky = 0; ky < ny; ky++) {
+    for (int kx = 0; kx < nx; kx++, pos++) {
+      if (src[pos] == T(0)) {
+        res[pos] = 0;
+        continue;
+      }
+
+      int label = 0;
+      // 上方（同一列的前一个像素）
+      if (kx > 0 && res[pos - 1] != 0) label = res[pos - 1];
+      if (ky > 0) {
+        // 左侧（前一列同一行）
+        int left = res[pos - nx];
+        if (left != 0) label = label ? _uf_union(parent.data(), label, left) : left;
+        if (diag) {
+          if (kx > 0) {
+            int ul = res[pos - nx - 1];
+            if (ul != 0) label = label ? _uf_union(parent.data(), label, ul) : ul;
+          }
+          if (kx < nx - 1) {
+            int ll = res[pos - nx + 1];
+            if (ll != 0) label = label ? _uf_union(parent.data(), label, ll) : ll;
+          }
+        }
+      }
+
+      if (label == 0) {
+        label = static_cast<int>(parent.size());
+        parent.push_back(label);
+      }
+      res[pos] = label;
+    }
+  }
+
+  return _bwlabel_finalize(res, nx * ny, work);
+}
+
+template <class T>
+int _bwlabel(const T *src, int *res, XYPoint size, int connectivity = 4) {
+  BWLabelWork work;
+  return _bwlabel(src, res, size, connectivity, work);
+}
+
+#endif
@@ -0,0 +1,139 @@
+#ifndef NPDS4CLIB_BWLABEL3D_H
+#define NPDS4CLIB_BWLABEL3D_H
+
+#include <vector>
+#include <cstdlib>
+#include <cstddef>
+#include "bwlabel.h"
+#include "regionprops.h"
+
+// 三维连通区域标记，数据按 [z, y, x] 列优先存储（z 变化最快），与 bf_sub_image / af_sub_image 一致
+// 与二维的 _bwlabel 相同，采用两遍扫描 + 并查集，最终标签按区域第一个体素的扫描顺序编号
+// connectivity 取 6、18 或 26
+
+// 扫描顺序中位于当前体素之前的邻居偏移
+struct Neighbor3D {
+  int d0, d1, d2;
+};
+
+inline std::vector<Neighbor3D> _backward_neighbors3d(int connectivity) {
+  std::vector<Neighbor3D> nb;
+  for (int d2 = -1; d2 <= 0; d2++) {
+    for (int d1 = -1; d1 <= 1; d1++) {
+      for (int d0 = -1; d0 <= 1; d0++) {
+        // 只保留扫描顺序在前的邻居
+        if (d2 == 0 && (d1 > 0 || (d1 == 0 && d0 >= 0))) continue;
+        int dist = std::abs(d0) + std::abs(d1) + std::abs(d2);
+        if (connectivity == 6 && dist > 1) continue;
+        if (connectivity == 18 && dist > 2) continue;
+        Neighbor3D n = {d0, d1, d2};
+        nb.push_back(n);
+      }
+    }
+  }
+  return nb;
+}
+
+// src 中非零体素为前景，res 输出标签（背景为 0），src 与 res 可以指向同一块内存
+template <class T>
+int _bwlabel3d(const T *src, int *res, int n0, int n1, int n2, int connectivity = 26) {
+  std::vector<Neighbor3D> nb = _backward_neighbors3d(connectivity);
+  std::vector<std::ptrdiff_t> offset(nb.size());
+  std::ptrdiff_t s1 = n0;
+  std::ptrdiff_t s2 = static_cast<std::ptrdiff_t>(n0) * n1;
+  for (size_t k = 0; k < nb.size(); k++) {
+    offset[k] = nb[k].d0 + nb[k].d1 * s1 + nb[k].d2 * s2;
+  }
+
+  std::vector<int> parent;
+  parent.reserve(256);
+  parent.push_back(0);
+
+  // 第一遍：分配临时标签并记录等价关系
+  std::ptrdiff_t pos = 0;
+  for (int i2 = 0; i2 < n2; i2++) {
+    for (int i1 = 0; i1 < n1; i1++) {
+      for (int i0 = 0; i0 < n0; i0++, pos++) {
+        if (src[pos] == T(0)) {
+          res[pos] = 0;
+          continue;
+        }
+
+        int label = 0;
+        for (size_t k = 0; k < nb.size(); k++) {
+          int j0 = i0 + nb[k].d0;
+          int j1 = i1 + nb[k].d1;
+          int j2 = i2 + nb[k].d2;
+          if (j0 < 0 || j0 >= n0 || j1 < 0 || j1 >= n1 || j2 < 0) continue;
+          int other = res[pos + offset[k]];
+          if (other == 0) continue;
+          label = label ? _uf_union(parent.data(), label, other) : other;
+        }
+
+        if (label == 0) {
+          label = static_cast<int>(parent.size());
+          parent.push_back(label);
+        }
+        res[pos] = label;
+      }
+    }
+  }
+
+  // 按临时标签的先后顺序分配连续的最终标签
+  int n_provisional = static_cast<int>(parent.size());
+  std::vector<int> final_label(n_provisional, 0);
+  int idx = 0;
+  for (int l = 1; l < n_provisional; l++) {
+    int root = _uf_find(parent.data(), l);
+    final_label[l] = (root == l) ? ++idx : final_label[root];
+  }
+
+  // 第二遍：写出最终标签
+  std::ptrdiff_t n = static_cast<std::ptrdiff_t>(n0) * n1 * n2;
+  for (std::ptrdiff_t i = 0; i < n; i++) {
+    res[i] = final_label[res[i]];
+  }
+
+  return idx;  // 返回连通区域数量
+}
+
+// 一次遍历三维标签，得到每个连通区域的体素数、层面内（y, x）的边界框及是否接触边界
+// RegionProps 中 area 为体素数，x 对应 y 方向（行），y 对应 x 方向（列）
+// on_border 标记层面内边界（距边界 buffer_size + 1 以内）；clear_z_border 为 true 时第一张和最后一张切片也算边界
+// z_last 为 false 时 (n0, n1, n2) 为 [z, y, x]；为 true 时为 NIfTI 原始布局的 [x, y, z]
+inline bool _regionprops3d(const int *labels, int num_labels, int n0, int n1, int n2,
+                           int buffer_size, bool clear_z_border, std::vector<RegionProps> &props,
+                           bool z_last = false) {
+  int ext = buffer_size + 1;
+  int ncol = z_last ? n0 : n2;
+  RegionProps empty = {0, n1, -1, ncol, -1, 0.0, 0.0, false};
+  props.assign(num_labels + 1, empty);
+
+  std::ptrdiff_t pos = 0;
+  for (int i2 = 0; i2 < n2; i2++) {
+    bool b2 = z_last ? (clear_z_border && (i2 == 0 || i2 == n2 - 1)) : ((i2 < ext) || (i2 >= n2 - ext));
+    for (int i1 = 0; i1 < n1; i1++) {
+      bool b1 = b2 || (i1 < ext) || (i1 >= n1 - ext);
+      for (int i0 = 0; i0 < n0; i0++, pos++) {
+        int label = labels[pos];
+        if (label <= 0) continue;
+        if (label > num_labels) return false;
+
+        int col = z_last ? i0 : i2;
+        bool b0 = z_last ? ((i0 < ext) || (i0 >= n0 - ext)) : (clear_z_border && (i0 == 0 || i0 == n0 - 1));
+        RegionProps &p = props[label];
+        p.area++;
+        if (i1 < p.x_min) p.x_min = i1;
+        if (i1 > p.x_max) p.x_max = i1;
+        if (col < p.y_min) p.y_min = col;
+        if (col > p.y_max) p.y_max = col;
+        p.sum_x += i1;
+        p.sum_y += col;
+        if (b1 || b0) p.on_border = true;
+      }
+    }
+  }
+  return true;
+}
+
+#endif
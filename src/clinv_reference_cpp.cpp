@@ -0,0 +1,75 @@
+#include <Rcpp.h>
+#include <string>
+#include <vector>
+#include "npds_core.h"
+using namespace Rcpp;
+
+// 读取 CSV 文件中名为 column 的一列数值并按升序排序，用作参考样本的分布
+// 只解析这一列，不构造数据框；非数值的字段视为错误；解析见 npds_core.h 中的 npds::read_sorted_column
+// [[Rcpp::export]]
+NumericVector read_sorted_column_cpp(std::string path, std::string column) {
+  std::vector<double> values = npds::read_sorted_column(path, column);
+  return NumericVector(values.begin(), values.end());
+}
+
+// 升序排列的参考样本 sorted 中大于 x[k] 的样本所占的比例，每个 x[k] 用一次二分查找
+// x[k] 为 NA / NaN 或参考样本为空时结果为 NA
+// [[Rcpp::export]]
+NumericVector sorted_exceedance_cpp(NumericVector sorted, NumericVector x) {
+  R_xlen_t n = sorted.size();
+  NumericVector p(x.size());
+  for (R_xlen_t k = 0; k < x.size(); k++) {
+    double v = npds::exceedance(REAL(sorted), n, x[k]);
+    p[k] = v != v ? NA_REAL : v;
+  }
+  return p;
+}
+
+// 结节大小组，见 npds::clinv_group；直径为 NA / NaN 时为 NA
+// [[Rcpp::export]]
+IntegerVector clinv_group_cpp(NumericVector diameter_mm) {
+  IntegerVector group(diameter_mm.size());
+  for (R_xlen_t k = 0; k < diameter_mm.size(); k++) {
+    int g = npds::clinv_group(diameter_mm[k]);
+    group[k] = g == 0 ? NA_INTEGER : g;
+  }
+  return group;
+}
+
+// 逐个 (npds[k], diameter_mm[k]) 调用 npds::hypothesis_test；reference 为四个组升序排列的参考样本，
+// 直接使用其数据，不复制
+// 无法检验（NPDS 或直径为 NA / NaN）时 progression 与 p_value 为 NA
+// [[Rcpp::export]]
+List hypothesis_test_cpp(NumericVector npds, NumericVector diameter_mm, NumericVector percentiles,
+                         List reference) {
+  if (percentiles.size() != 4 || reference.size() != 4) {
+    stop("hypothesis_test_cpp: percentiles and reference must have four groups.");
+  }
+  if (diameter_mm.size() != npds.size()) {
+    stop("hypothesis_test_cpp: npds and diameter_mm must have the same length.");
+  }
+  const double *data[4];
+  std::ptrdiff_t size[4];
+  for (int g = 0; g < 4; g++) {
+    SEXP sample = reference[g];
+    if (TYPEOF(sample) != REALSXP) {
+      stop("hypothesis_test_cpp: the reference samples must be double vectors.");
+    }
+    data[g] = REAL(sample);
+    size[g] = XLENGTH(sample);
+  }
+
+  R_xlen_t n = npds.size();
+  IntegerVector group(n);
+  LogicalVector progression(n);
+  NumericVector p_value(n);
+  for (R_xlen_t k = 0; k < n; k++) {
+    npds::TestResult test = npds::hypothesis_test(npds[k], diameter_mm[k], REAL(percentiles), data, size);
+    group[k] = test.group == 0 ? NA_INTEGER : test.group;
+    progression[k] = test.progression < 0 ? NA_LOGICAL : test.progression;
+    p_value[k] = test.p_value != test.p_value ? NA_REAL : test.p_value;
+  }
+  return List::create(Named("group") = group,
+                      Named("progression") = progression,
+                      Named("p_value") = p_value);
+}
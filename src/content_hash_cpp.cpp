@@ -0,0 +1,62 @@
+#include <Rcpp.h>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "typed_volume.h"
+using namespace Rcpp;
+
+// 64 位 FNV-1a 散列，用作磁盘缓存的键；不用于安全用途
+static const uint64_t FNV_OFFSET = 14695981039346656037ULL;
+static const uint64_t FNV_PRIME = 1099511628211ULL;
+
+static uint64_t fnv1a(const unsigned char *data, std::size_t n, uint64_t h) {
+  for (std::size_t i = 0; i < n; i++) {
+    h ^= data[i];
+    h *= FNV_PRIME;
+  }
+  return h;
+}
+
+// 依次散列 paths 中每个文件的全部字节（.nii.gz 按压缩后的字节）以及字符串 extra，返回 16 位十六进制字符串
+// 文件之间插入文件长度，使文件的边界也参与散列
+// [[Rcpp::export]]
+std::string content_hash_cpp(CharacterVector paths, std::string extra = "") {
+  uint64_t h = FNV_OFFSET;
+  std::vector<unsigned char> buffer(1 << 20);
+  for (R_xlen_t k = 0; k < paths.size(); k++) {
+    std::string path = as<std::string>(paths[k]);
+    std::FILE *f = std::fopen(path.c_str(), "rb");
+    if (f == NULL) {
+      stop("content_hash_cpp: cannot read " + path + ".");
+    }
+    uint64_t length = 0;
+    std::size_t n;
+    while ((n = std::fread(buffer.data(), 1, buffer.size(), f)) > 0) {
+      h = fnv1a(buffer.data(), n, h);
+      length += n;
+    }
+    std::fclose(f);
+    h = fnv1a(reinterpret_cast<const unsigned char *>(&length), sizeof(length), h);
+  }
+  h = fnv1a(reinterpret_cast<const unsigned char *>(extra.data()), extra.size(), h);
+
+  char key[17];
+  std::snprintf(key, sizeof(key), "%016llx", static_cast<unsigned long long>(h));
+  return std::string(key);
+}
+
+// 体数据内容的散列：存储类型、布局、逻辑维度和全部数据字节，返回 16 位十六进制字符串
+// 用来确认缓存的中间结果（例如组织块的倒数矩阵）确实来自同一个子区域，而不只是维度相同
+// [[Rcpp::export]]
+std::string volume_hash_cpp(SEXP x) {
+  TypedVolume v = typed_volume(x, "volume_hash_cpp");
+  uint64_t h = FNV_OFFSET;
+  int header[5] = {static_cast<int>(v.type), v.xyz ? 1 : 0, v.n_slices, v.nrow, v.ncol};
+  h = fnv1a(reinterpret_cast<const unsigned char *>(header), sizeof(header), h);
+  h = fnv1a(static_cast<const unsigned char *>(v.data), static_cast<std::size_t>(v.n) * storage_bytes(v.type), h);
+
+  char key[17];
+  std::snprintf(key, sizeof(key), "%016llx", static_cast<unsigned long long>(h));
+  return std::string(key);
+}
@@ -0,0 +1,156 @@
+#ifndef NPDS4CLIB_DETECTION_MATRIX_H
+#define NPDS4CLIB_DETECTION_MATRIX_H
+
+#include <Rcpp.h>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "npds.h"
+
+// 紧凑存储的检测矩阵
+// 检测矩阵 c(R, M, block_num) 的元素只取 -1、0、+1，除 double 数组外还可以保存为 raw 向量：
+//   "int8"：每个元素一个字节（-1 存为 0xff），大小为 double 的 1/8
+//   "bits"：正、负两个位平面依次存放，每个位平面 ceiling(n / 8) 个字节，
+//           第 i 个元素（与 double 数组的下标 r + R * m + R * M * b 相同）为第 i / 8 个字节的第 i % 8 位，大小为 double 的 1/32
+// 属性 npds_detection 为存储方式，npds_dim 为逻辑维度 c(R, M, block_num)
+// 需要 double 数组时用 expand_detection_matrix_cpp 展开，可以只展开部分切片
+
+enum DetectionFormat {
+  DETECTION_DOUBLE,
+  DETECTION_INT8,
+  DETECTION_BITS
+};
+
+inline DetectionFormat parse_detection_format(const std::string &name, const char *caller) {
+  if (name == "double") return DETECTION_DOUBLE;
+  if (name == "int8") return DETECTION_INT8;
+  if (name == "bits") return DETECTION_BITS;
+  Rcpp::stop(std::string(caller) + ": detection_format must be one of \"double\", \"int8\" or \"bits\".");
+  return DETECTION_DOUBLE;
+}
+
+inline const char *detection_format_name(DetectionFormat format) {
+  switch (format) {
+  case DETECTION_DOUBLE: return "double";
+  case DETECTION_INT8: return "int8";
+  case DETECTION_BITS: return "bits";
+  }
+  return "unknown";
+}
+
+// 一个位平面的字节数
+inline R_xlen_t detection_plane_bytes(R_xlen_t n) {
+  return (n + 7) / 8;
+}
+
+// 新建 c(R, M, block_num) 的检测矩阵；double 使用 R 的 dim 属性，其余为带属性的 raw 向量
+inline SEXP new_detection_matrix(DetectionFormat format, int R, int M, int block_num) {
+  R_xlen_t n = static_cast<R_xlen_t>(R) * M * block_num;
+  Rcpp::IntegerVector d = Rcpp::IntegerVector::create(R, M, block_num);
+  SEXP out;
+  if (format == DETECTION_DOUBLE) {
+    out = PROTECT(Rf_allocVector(REALSXP, n));
+    std::memset(REAL(out), 0, n * sizeof(double));
+    Rf_setAttrib(out, R_DimSymbol, d);
+  } else {
+    R_xlen_t bytes = format == DETECTION_INT8 ? n : 2 * detection_plane_bytes(n);
+    out = PROTECT(Rf_allocVector(RAWSXP, bytes));
+    std::memset(RAW(out), 0, bytes);
+    SEXP name = PROTECT(Rf_mkString(detection_format_name(format)));
+    Rf_setAttrib(out, Rf_install("npds_detection"), name);
+    Rf_setAttrib(out, Rf_install("npds_dim"), d);
+    UNPROTECT(1);
+  }
+  UNPROTECT(1);
+  return out;
+}
+
+// 读取检测矩阵的存储方式和维度 dims = (R, M, block_num)
+inline DetectionFormat detection_matrix_info(SEXP x, int dims[3], const char *caller) {
+  DetectionFormat format;
+  SEXP dim_attr;
+  if (TYPEOF(x) == REALSXP) {
+    format = DETECTION_DOUBLE;
+    dim_attr = Rf_getAttrib(x, R_DimSymbol);
+  } else {
+    SEXP name = Rf_getAttrib(x, Rf_install("npds_detection"));
+    if (TYPEOF(x) != RAWSXP || TYPEOF(name) != STRSXP) {
+      Rcpp::stop(std::string(caller) + ": x must be a double array or a detection matrix stored as \"int8\" or \"bits\".");
+    }
+    format = parse_detection_format(CHAR(STRING_ELT(name, 0)), caller);
+    dim_attr = Rf_getAttrib(x, Rf_install("npds_dim"));
+  }
+  if (Rf_isNull(dim_attr) || Rf_xlength(dim_attr) != 3) {
+    Rcpp::stop(std::string(caller) + ": the detection matrix must have dimensions c(R, M, block_num).");
+  }
+  Rcpp::IntegerVector d(dim_attr);
+  for (int k = 0; k < 3; k++) dims[k] = d[k];
+
+  R_xlen_t n = static_cast<R_xlen_t>(dims[0]) * dims[1] * dims[2];
+  R_xlen_t expected = format == DETECTION_DOUBLE ? n : format == DETECTION_INT8 ? n : 2 * detection_plane_bytes(n);
+  if (Rf_xlength(x) != expected) {
+    Rcpp::stop(std::string(caller) + ": npds_dim does not match the stored data.");
+  }
+  return format;
+}
+
+// 把 -1/0/+1 的 int8 检测结果打包为正、负两个位平面；按字节并行，各线程写不同的字节
+inline void _pack_detection_bits(const int8_t *values, R_xlen_t n, uint8_t *pos, uint8_t *neg, int nthreads) {
+  R_xlen_t n_bytes = detection_plane_bytes(n);
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(nthreads) schedule(static)
+#endif
+  for (R_xlen_t k = 0; k < n_bytes; k++) {
+    uint8_t p = 0, q = 0;
+    R_xlen_t end = (k + 1) * 8 < n ? (k + 1) * 8 : n;
+    for (R_xlen_t i = k * 8; i < end; i++) {
+      p |= static_cast<uint8_t>(values[i] > 0) << (i - k * 8);
+      q |= static_cast<uint8_t>(values[i] < 0) << (i - k * 8);
+    }
+    pos[k] = p;
+    neg[k] = q;
+  }
+}
+
+// 检测矩阵第 i 个元素的值
+inline double detection_value(DetectionFormat format, SEXP x, R_xlen_t n, R_xlen_t i) {
+  switch (format) {
+  case DETECTION_DOUBLE: return REAL(x)[i];
+  case DETECTION_INT8: return reinterpret_cast<const int8_t *>(RAW(x))[i];
+  case DETECTION_BITS: {
+    const uint8_t *pos = RAW(x);
+    const uint8_t *neg = pos + detection_plane_bytes(n);
+    int bit = static_cast<int>(i % 8);
+    return static_cast<double>((pos[i / 8] >> bit) & 1) - static_cast<double>((neg[i / 8] >> bit) & 1);
+  }
+  }
+  return 0.0;
+}
+
+// 由所有切片的变化率生成 format 存储的检测矩阵（返回值）与 detection_list，结果与 _hu_ratio_detection_slices 相同
+// "bits" 先按切片并行写出 int8 的检测结果，再按字节打包，避免相邻切片写同一个字节
+inline SEXP _hu_ratio_detection_matrix(const double *change, int M, int block_num,
+                                       const double *threshold, int R, DetectionFormat format,
+                                       double *detection_list, int nthreads) {
+  Rcpp::RObject out = new_detection_matrix(format, R, M, block_num);
+  switch (format) {
+  case DETECTION_DOUBLE:
+    _hu_ratio_detection_slices(change, M, block_num, threshold, R, REAL(out), detection_list, NULL, nthreads);
+    break;
+  case DETECTION_INT8:
+    _hu_ratio_detection_slices(change, M, block_num, threshold, R, reinterpret_cast<int8_t *>(RAW(out)),
+                               detection_list, NULL, nthreads);
+    break;
+  case DETECTION_BITS: {
+    R_xlen_t n = static_cast<R_xlen_t>(R) * M * block_num;
+    std::vector<int8_t> values(n);
+    _hu_ratio_detection_slices(change, M, block_num, threshold, R, values.data(), detection_list, NULL, nthreads);
+    _pack_detection_bits(values.data(), n, RAW(out), RAW(out) + detection_plane_bytes(n), nthreads);
+    break;
+  }
+  }
+  return out;
+}
+
+#endif
@@ -0,0 +1,78 @@
+#include <Rcpp.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "detection_matrix.h"
+using namespace Rcpp;
+
+// 把 double 的检测矩阵 c(R, M, block_num) 转换为 detection_format（"double"、"int8" 或 "bits"）存储
+// 已紧凑存储的检测矩阵先展开再转换；元素必须为 -1、0 或 +1
+// [[Rcpp::export]]
+SEXP pack_detection_matrix_cpp(SEXP x, std::string detection_format = "bits") {
+  const char *caller = "pack_detection_matrix_cpp";
+  DetectionFormat format = parse_detection_format(detection_format, caller);
+  int dims[3];
+  DetectionFormat current = detection_matrix_info(x, dims, caller);
+  if (current == format) return x;
+
+  R_xlen_t n = static_cast<R_xlen_t>(dims[0]) * dims[1] * dims[2];
+  std::vector<int8_t> values(n);
+  for (R_xlen_t i = 0; i < n; i++) {
+    double v = detection_value(current, x, n, i);
+    if (v != 1.0 && v != 0.0 && v != -1.0) {
+      stop("pack_detection_matrix_cpp: a detection matrix may only contain -1, 0 and 1.");
+    }
+    values[i] = static_cast<int8_t>(v);
+  }
+
+  RObject out = new_detection_matrix(format, dims[0], dims[1], dims[2]);
+  switch (format) {
+  case DETECTION_DOUBLE:
+    for (R_xlen_t i = 0; i < n; i++) REAL(out)[i] = values[i];
+    break;
+  case DETECTION_INT8:
+    for (R_xlen_t i = 0; i < n; i++) reinterpret_cast<int8_t *>(RAW(out))[i] = values[i];
+    break;
+  case DETECTION_BITS:
+    _pack_detection_bits(values.data(), n, RAW(out), RAW(out) + detection_plane_bytes(n), 1);
+    break;
+  }
+  return out;
+}
+
+// 把检测矩阵展开为 double 数组 c(R, length(slices), block_num)；slices 为从 1 开始的切片下标，NULL 时展开所有切片
+// 只读取所选切片的元素，不生成整个 double 数组
+// [[Rcpp::export]]
+NumericVector expand_detection_matrix_cpp(SEXP x, Nullable<IntegerVector> slices = R_NilValue) {
+  const char *caller = "expand_detection_matrix_cpp";
+  int dims[3];
+  DetectionFormat format = detection_matrix_info(x, dims, caller);
+  int R = dims[0], M = dims[1], block_num = dims[2];
+
+  std::vector<int> selected;
+  if (slices.isNull()) {
+    for (int m = 0; m < M; m++) selected.push_back(m);
+  } else {
+    IntegerVector s(slices.get());
+    for (int k = 0; k < s.size(); k++) {
+      if (s[k] == NA_INTEGER || s[k] < 1 || s[k] > M) {
+        stop("expand_detection_matrix_cpp: slices are out of range.");
+      }
+      selected.push_back(s[k] - 1);
+    }
+  }
+
+  int n_out = static_cast<int>(selected.size());
+  R_xlen_t n = static_cast<R_xlen_t>(R) * M * block_num;
+  NumericVector out(static_cast<R_xlen_t>(R) * n_out * block_num);
+  out.attr("dim") = IntegerVector::create(R, n_out, block_num);
+  double *dst = REAL(out);
+  for (int b = 0; b < block_num; b++) {
+    for (int k = 0; k < n_out; k++) {
+      // 元素 [r, m, b] 位于 r + R * m + R * M * b
+      R_xlen_t src = static_cast<R_xlen_t>(R) * selected[k] + static_cast<R_xlen_t>(R) * M * b;
+      for (int r = 0; r < R; r++) *dst++ = detection_value(format, x, n, src + r);
+    }
+  }
+  return out;
+}
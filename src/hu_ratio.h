@@ -0,0 +1,264 @@
+#ifndef NPDS4CLIB_HU_RATIO_H
+#define NPDS4CLIB_HU_RATIO_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "block_view.h"
+#include "hu_ratio_simd.h"
+
+// 每个并行任务处理一个组织块上连续的 HU_RATIO_SLICE_CHUNK 张切片
+// 取 AVX-512 宽度的整数倍，使任务内的累加仍能完整向量化
+#define HU_RATIO_SLICE_CHUNK 16
+
+// 所有切片、所有组织块的 HU 比值变化率，按 (组织块, 切片段) 划分任务并行计算
+// 对第 m 张切片的第 b 个组织块：
+//   mean_ratio_s = mean(nodule_block_s / |block_s + 0.1|)，s = 1 为基线，s = 2 为随访
+//   change[m * block_num + b] = (mean_ratio_2 - mean_ratio_1) / |mean_ratio_1|
+// layout 给出数据位置：block(s, b, p) 与 nodule(s, p) 返回第 p 个像素在第 0 张切片上的指针，
+// 第 m 张切片上的值相距 m * layout.slice_stride；slice_stride 为 1 时直接沿切片方向累加，
+// 否则先把一个切片段的值收集到连续的工作区再累加（累加的值和顺序不变）
+// 每个任务只写自己的 change 元素，像素按 p 递增的顺序累加，
+// 因此结果与线程数、任务调度顺序无关，与单线程计算逐位一致
+// 调度使用 schedule(dynamic)，空闲线程取下一个任务
+// BLOCKS、PIXELS 不为 0 时为编译期已知的组织块数与像素数（见 BlockSize），像素循环的次数固定
+// active 不为 NULL 时只计算切片段内至少有一张切片 active[m * block_num + b] 不为 0 的任务（见 block_coverage.h），
+// 其余任务的 change 不写出
+template <int BLOCKS = 0, int PIXELS = 0, class Layout>
+inline void _hu_ratio_change_tasks(const Layout &layout, int n_slices, int block_num, int n_pixels,
+                                   double *change, int nthreads, const uint8_t *active = NULL) {
+  typedef typename Layout::value_type value_type;
+  if (BLOCKS) block_num = BLOCKS;
+  if (PIXELS) n_pixels = PIXELS;
+  int n_chunks = (n_slices + HU_RATIO_SLICE_CHUNK - 1) / HU_RATIO_SLICE_CHUNK;
+  int n_tasks = block_num * n_chunks;
+  double n_pixels_d = static_cast<double>(n_pixels);
+
+  // 稀疏评估的任务列表
+  std::vector<int> tasks;
+  if (active != NULL) {
+    for (int task = 0; task < n_tasks; task++) {
+      int b = task / n_chunks;
+      int m0 = (task % n_chunks) * HU_RATIO_SLICE_CHUNK;
+      int n = std::min(HU_RATIO_SLICE_CHUNK, n_slices - m0);
+      bool any = false;
+      for (int t = 0; t < n && !any; t++) any = active[static_cast<std::ptrdiff_t>(m0 + t) * block_num + b] != 0;
+      if (any) tasks.push_back(task);
+    }
+    n_tasks = static_cast<int>(tasks.size());
+  }
+
+#ifdef _OPENMP
+#pragma omp parallel num_threads(nthreads)
+#endif
+  {
+    // 每个线程一块累加工作区和一块收集工作区
+    double acc[2 * HU_RATIO_SLICE_CHUNK];
+    double *acc_1 = acc;
+    double *acc_2 = acc + HU_RATIO_SLICE_CHUNK;
+    double gather[4][HU_RATIO_SLICE_CHUNK];
+    std::ptrdiff_t stride = layout.slice_stride;
+
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+    for (int k = 0; k < n_tasks; k++) {
+      int task = active != NULL ? tasks[k] : k;
+      int b = task / n_chunks;
+      int m0 = (task % n_chunks) * HU_RATIO_SLICE_CHUNK;
+      int n = std::min(HU_RATIO_SLICE_CHUNK, n_slices - m0);
+
+      std::fill(acc, acc + 2 * HU_RATIO_SLICE_CHUNK, 0.0);
+      for (int p = 0; p < n_pixels; p++) {
+        if (stride == 1) {
+          _hu_ratio_accumulate(layout.nodule(0, p) + m0, layout.block(0, b, p) + m0,
+                               layout.nodule(1, p) + m0, layout.block(1, b, p) + m0,
+                               1, acc_1, acc_2, n);
+        } else {
+          const value_type *src[4] = {layout.nodule(0, p), layout.block(0, b, p),
+                                      layout.nodule(1, p), layout.block(1, b, p)};
+          for (int a = 0; a < 4; a++) {
+            for (int t = 0; t < n; t++) gather[a][t] = static_cast<double>(src[a][(m0 + t) * stride]);
+          }
+          _hu_ratio_accumulate(gather[0], gather[1], gather[2], gather[3], 1, acc_1, acc_2, n);
+        }
+      }
+
+      for (int t = 0; t < n; t++) {
+        double mean_ratio_1 = acc_1[t] / n_pixels_d;
+        double mean_ratio_2 = acc_2[t] / n_pixels_d;
+        change[static_cast<std::ptrdiff_t>(m0 + t) * block_num + b] = (mean_ratio_2 - mean_ratio_1) / std::fabs(mean_ratio_1);
+      }
+    }
+  }
+}
+
+// 体数据的数据位置：组织块与结节块都通过块视图直接读取
+// 第 p 个像素对应块内的 (k, l) = (p % split_size, p / split_size)，即列在外层、行在内层
+// S、N 为 BlockSize 的编译期大小，特化版本中这里的除法与取余都是移位
+template <class T, int S = 0, int N = 0>
+struct HURatioVolumeLayout {
+  typedef T value_type;
+  SliceView<T> slice[2];
+  BlockView<T> nodule_view[2];
+  BlockSize<S, N> size;
+  std::ptrdiff_t slice_stride;
+
+  const T *block(int s, int b, int p) const {
+    int split_size = size.split_size(), split_num = size.split_num();
+    BlockView<T> view = slice[s].tissue_block(b / split_num, b % split_num, split_size);
+    return &view(p % split_size, p / split_size);
+  }
+  const T *nodule(int s, int p) const {
+    int split_size = size.split_size();
+    return &nodule_view[s](p % split_size, p / split_size);
+  }
+};
+
+// 按 BlockSize 计算整个体数据的变化率，由 _hu_ratio_change_volume 经 dispatch_block_size 调用
+template <class T>
+struct HURatioChangeVolumeTask {
+  const T *bf, *af;
+  const VolumeLayout *volume;
+  int x_start, y_start;
+  double *change;
+  int nthreads;
+  const uint8_t *active;
+
+  template <int S, int N>
+  void operator()(const BlockSize<S, N> &size) {
+    // 各视图都取第 0 张切片，第 m 张切片上的值相距 m * slice_stride
+    HURatioVolumeLayout<T, S, N> layout;
+    layout.slice[0] = volume_slice(bf, *volume, 0);
+    layout.slice[1] = volume_slice(af, *volume, 0);
+    layout.nodule_view[0] = layout.slice[0].block(y_start, x_start, size.split_size());
+    layout.nodule_view[1] = layout.slice[1].block(y_start, x_start, size.split_size());
+    layout.size = size;
+    layout.slice_stride = volume->slice_stride;
+
+    _hu_ratio_change_tasks<N * N, S * S>(layout, volume->n_slices, size.block_num(), size.n_pixels(),
+                                         change, nthreads, active);
+  }
+};
+
+// 整个体数据上所有组织块的 HU 比值变化率，b = i * split_num + j
+// 组织块与结节块都通过块视图直接从体数据中读取，不需要先生成组织块数组
+// volume 给出两期共同的内存布局：[z, y, x] 布局 z 方向连续存储，同一像素在各切片上的值相邻，
+// 融合累加核直接沿切片方向向量化；NIfTI 原始的 [x, y, z] 布局按切片步长收集后累加，结果逐位相同
+// split_size = 32、64 且 split_num = 512 / split_size 时使用编译期特化的版本（见 BlockSize），结果与通用版本逐位相同
+// active 不为 NULL 时只计算肺掩膜覆盖率足够的组织块（见 _hu_ratio_change_tasks）
+template <class T>
+inline void _hu_ratio_change_volume(const T *bf, const T *af, const VolumeLayout &volume,
+                                    int x_start, int y_start, int split_size, int split_num,
+                                    double *change, int nthreads = 1, const uint8_t *active = NULL) {
+  HURatioChangeVolumeTask<T> task = {bf, af, &volume, x_start, y_start, change, nthreads, active};
+  dispatch_block_size(split_size, split_num, task);
+}
+
+// [z, y, x] 体数据
+template <class T>
+inline void _hu_ratio_change_volume(const T *bf, const T *af, int n_slices, int nrow, int ncol,
+                                    int x_start, int y_start, int split_size, int split_num,
+                                    double *change, int nthreads = 1) {
+  _hu_ratio_change_volume(bf, af, zyx_layout(n_slices, nrow, ncol), x_start, y_start, split_size, split_num,
+                          change, nthreads);
+}
+
+// generate_lung_tissue_blocksC 生成的组织块数组的数据位置
+// A_s 维度为 c(M, n_rows, n_pixels)，(m, b, p) 位于 m + M * b + M * n_rows * p；
+// 结节块为 A_s 的第 nodule_row 行，或为维度 c(M, 2, n_pixels) 的 nodule_block_list 的第 s 行
+// 各切片上的值连续存放，slice_stride 为 1
+struct HURatioBlockLayout {
+  typedef double value_type;
+  const double *A[2];
+  const double *nodule_ptr[2];
+  std::ptrdiff_t block_stride, pixel_stride, nodule_stride;
+  std::ptrdiff_t slice_stride;
+
+  const double *block(int s, int b, int p) const {
+    return A[s] + b * block_stride + p * pixel_stride;
+  }
+  const double *nodule(int s, int p) const {
+    return nodule_ptr[s] + p * nodule_stride;
+  }
+};
+
+// 根据变化率与阈值生成检测结果
+// detection_matrix 为 NULL 时只计算 detection_list；否则 (r, b) 元素写在 detection_matrix[r * r_stride + b * b_stride]，
+// 可以是 double，也可以是紧凑存储用的 int8_t（见 detection_matrix.h）
+// detection_list 的第 r 个元素写在 detection_list[r * list_stride]，为 +1/-1/0 的和除以 block_num
+template <class T>
+inline void _hu_ratio_detection(const double *change, int block_num,
+                                const double *detection_threshold, int R,
+                                T *detection_matrix, std::ptrdiff_t r_stride, std::ptrdiff_t b_stride,
+                                double *detection_list, std::ptrdiff_t list_stride) {
+  for (int r = 0; r < R; r++) {
+    double threshold = detection_threshold[r];
+    int total = 0;
+    for (int b = 0; b < block_num; b++) {
+      int value = 0;
+      if (change[b] > threshold) {
+        value = 1;
+      } else if (change[b] < -threshold) {
+        value = -1;
+      }
+      total += value;
+      if (detection_matrix != NULL) {
+        detection_matrix[r * r_stride + b * b_stride] = static_cast<T>(value);
+      }
+    }
+    detection_list[r * list_stride] = static_cast<double>(total) / block_num;
+  }
+}
+
+// 不生成检测矩阵的检测列表计算
+// 对阈值 t，detection_list = (#{change > t} - #{change < -t}) / block_num，是排序后 |change| 的阶梯函数
+// 将正的变化率与负变化率的绝对值分别排序后，每个阈值只需两次二分查找，复杂度 O(block_num log block_num + R log block_num)
+// 结果与 _hu_ratio_detection 逐个比较得到的完全相同；NaN 的变化率既不大于也不小于阈值，不参与计数
+// pos、neg 为工作区，可在多次调用之间复用
+// normaliser > 0 时计数除以 normaliser 而不是 block_num（与 HU_ratio_nodule_progression_detection_slice_cpp
+// 的 block_num 参数一致）
+inline void _hu_ratio_detection_sorted(const double *change, int block_num,
+                                       const double *detection_threshold, int R,
+                                       double *detection_list, std::ptrdiff_t list_stride,
+                                       std::vector<double> &pos, std::vector<double> &neg,
+                                       int normaliser = 0) {
+  if (normaliser <= 0) normaliser = block_num;
+  pos.clear();
+  neg.clear();
+  for (int b = 0; b < block_num; b++) {
+    if (change[b] > 0) {
+      pos.push_back(change[b]);
+    } else if (change[b] < 0) {
+      neg.push_back(-change[b]);
+    }
+  }
+  std::sort(pos.begin(), pos.end());
+  std::sort(neg.begin(), neg.end());
+
+  for (int r = 0; r < R; r++) {
+    double threshold = detection_threshold[r];
+    // n_up 为 change > t 的个数，n_down 为 change < -t 的个数
+    std::ptrdiff_t n_up, n_down;
+    if (threshold >= 0) {
+      n_up = pos.end() - std::upper_bound(pos.begin(), pos.end(), threshold);
+      n_down = neg.end() - std::upper_bound(neg.begin(), neg.end(), threshold);
+    } else {
+      // 阈值为负时两种情况会重叠，退回逐个比较，保持与 _hu_ratio_detection 一致
+      n_up = 0;
+      n_down = 0;
+      for (int b = 0; b < block_num; b++) {
+        if (change[b] > threshold) {
+          n_up++;
+        } else if (change[b] < -threshold) {
+          n_down++;
+        }
+      }
+    }
+    detection_list[r * list_stride] = static_cast<double>(n_up - n_down) / normaliser;
+  }
+}
+
+#endif
@@ -0,0 +1,178 @@
+#ifndef NPDS4CLIB_HU_RATIO_FFT_H
+#define NPDS4CLIB_HU_RATIO_FFT_H
+
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <vector>
+#include "block_view.h"
+
+// 候选结节中心窗口上 HU 比值之和的 FFT 互相关形式
+// 结节块左上角平移 (dy, dx) 后，组织块 b 的比值之和为
+//   S_b(dy, dx) = sum_{k, l} W_b[k, l] * slice[y0 + dy + k, x0 + dx + l]
+// 其中 W_b 为 hu_ratio_gemm.h 中的倒数矩阵；对 0 <= dy, dx <= 2 * radius，这是切片窗口
+// （边长 split_size + 2 * radius）与核 W_b 的互相关，由 FFT 一次得到所有平移
+// 窗口与核补零到 2 的幂 P >= split_size + 2 * radius，所需的平移不会发生循环卷绕
+// 两个组织块的核合成一个复数核 W_b1 - i W_b2，逆变换的实部、虚部分别为两个块的结果
+// FFT 的舍入误差使结果与逐块求和只在舍入误差内一致
+
+typedef std::complex<double> fft_complex;
+
+// 基 2 FFT 的位反转表与旋转因子
+struct FFTPlan {
+  int n;
+  std::vector<int> rev;
+  std::vector<fft_complex> twiddle;  // exp(-2 pi i k / n)，k < n / 2
+};
+
+// 不小于 n 的 2 的幂
+inline int _fft_size(int n) {
+  int p = 1;
+  while (p < n) p <<= 1;
+  return p;
+}
+
+inline FFTPlan _fft_plan(int n) {
+  FFTPlan plan;
+  plan.n = n;
+  plan.rev.assign(n, 0);
+  int bits = 0;
+  while ((1 << bits) < n) bits++;
+  for (int k = 0; k < n; k++) {
+    int r = 0;
+    for (int b = 0; b < bits; b++) {
+      if (k & (1 << b)) r |= 1 << (bits - 1 - b);
+    }
+    plan.rev[k] = r;
+  }
+  const double pi = 3.14159265358979323846;
+  plan.twiddle.resize(n / 2);
+  for (int k = 0; k < n / 2; k++) {
+    plan.twiddle[k] = fft_complex(std::cos(2 * pi * k / n), -std::sin(2 * pi * k / n));
+  }
+  return plan;
+}
+
+// 复数乘法 a * b 与 a * conj(b)；按实部、虚部展开，不经过 std::complex 对 Inf / NaN 的特殊处理
+inline fft_complex _complex_mul(const fft_complex &a, const fft_complex &b) {
+  return fft_complex(a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real());
+}
+
+inline fft_complex _complex_mul_conj(const fft_complex &a, const fft_complex &b) {
+  return fft_complex(a.real() * b.real() + a.imag() * b.imag(), a.imag() * b.real() - a.real() * b.imag());
+}
+
+// 原地 FFT，inverse 为 true 时为逆变换（不除以 n）
+inline void _fft(const FFTPlan &plan, fft_complex *a, bool inverse) {
+  int n = plan.n;
+  for (int k = 0; k < n; k++) {
+    int r = plan.rev[k];
+    if (k < r) std::swap(a[k], a[r]);
+  }
+  for (int len = 2; len <= n; len <<= 1) {
+    int half = len / 2, step = n / len;
+    for (int start = 0; start < n; start += len) {
+      for (int k = 0; k < half; k++) {
+        const fft_complex &w = plan.twiddle[k * step];
+        fft_complex u = a[start + k];
+        fft_complex v = inverse ? _complex_mul_conj(a[start + k + half], w) : _complex_mul(a[start + k + half], w);
+        a[start + k] = u + v;
+        a[start + k + half] = u - v;
+      }
+    }
+  }
+}
+
+// 每个线程的工作区
+struct HURatioFFTWork {
+  std::vector<fft_complex> kernel;  // P x P，行优先
+  std::vector<fft_complex> line;    // 一行或一列
+  std::vector<fft_complex> partial; // (2 * radius + 1) x P，列方向逆变换后保留的行
+
+  void resize(int P, int n_offsets_1d) {
+    kernel.resize(static_cast<std::size_t>(P) * P);
+    line.resize(P);
+    partial.resize(static_cast<std::size_t>(n_offsets_1d) * P);
+  }
+};
+
+// 第 m 张切片上左上角为 (y0, x0)、边长为 size 的窗口的二维频谱，写入 spectrum[u * P + v]
+template <class T>
+inline void _hu_ratio_window_spectrum(const T *volume, const VolumeLayout &layout, int m,
+                                      int y0, int x0, int size, const FFTPlan &plan,
+                                      fft_complex *spectrum, fft_complex *line) {
+  int P = plan.n;
+  BlockView<T> window = volume_slice(volume, layout, m).block(y0, x0, size);
+  for (int k = 0; k < P; k++) {
+    fft_complex *row = spectrum + static_cast<std::ptrdiff_t>(k) * P;
+    for (int l = 0; l < P; l++) {
+      row[l] = (k < size && l < size) ? fft_complex(static_cast<double>(window(k, l)), 0.0) : fft_complex(0.0, 0.0);
+    }
+    if (k < size) _fft(plan, row, false);
+  }
+  for (int l = 0; l < P; l++) {
+    for (int k = 0; k < P; k++) line[k] = spectrum[static_cast<std::ptrdiff_t>(k) * P + l];
+    _fft(plan, line, false);
+    for (int k = 0; k < P; k++) spectrum[static_cast<std::ptrdiff_t>(k) * P + l] = line[k];
+  }
+}
+
+// 由窗口频谱与一张切片的倒数矩阵 w（w[b + block_num * (k * split_size + l)]）计算所有平移下所有组织块的比值之和
+// sums[b + block_num * (dy * n + dx)]，n = 2 * radius + 1
+inline void _hu_ratio_correlate_blocks(const fft_complex *spectrum, const double *w, int block_num,
+                                       int split_size, int radius, const FFTPlan &plan,
+                                       double *sums, HURatioFFTWork &work) {
+  int P = plan.n;
+  int n = 2 * radius + 1;
+  double scale = 1.0 / (static_cast<double>(P) * P);
+  fft_complex *kernel = work.kernel.data();
+  fft_complex *line = work.line.data();
+  fft_complex *partial = work.partial.data();
+
+  for (int b1 = 0; b1 < block_num; b1 += 2) {
+    int b2 = b1 + 1;
+    bool pair = b2 < block_num;
+
+    // 复数核 W_b1 - i W_b2：只有前 split_size 行非零，行变换只做这些行
+    for (int k = 0; k < P; k++) {
+      fft_complex *row = kernel + static_cast<std::ptrdiff_t>(k) * P;
+      if (k >= split_size) {
+        for (int l = 0; l < P; l++) row[l] = fft_complex(0.0, 0.0);
+        continue;
+      }
+      for (int l = 0; l < P; l++) {
+        if (l < split_size) {
+          std::ptrdiff_t p = static_cast<std::ptrdiff_t>(block_num) * (k * split_size + l);
+          row[l] = fft_complex(w[b1 + p], pair ? -w[b2 + p] : 0.0);
+        } else {
+          row[l] = fft_complex(0.0, 0.0);
+        }
+      }
+      _fft(plan, row, false);
+    }
+
+    // 逐列：列变换、与窗口频谱的共轭相乘、列逆变换，只保留前 n 行
+    for (int l = 0; l < P; l++) {
+      for (int k = 0; k < P; k++) line[k] = kernel[static_cast<std::ptrdiff_t>(k) * P + l];
+      _fft(plan, line, false);
+      for (int k = 0; k < P; k++) {
+        line[k] = _complex_mul_conj(spectrum[static_cast<std::ptrdiff_t>(k) * P + l], line[k]);
+      }
+      _fft(plan, line, true);
+      for (int dy = 0; dy < n; dy++) partial[static_cast<std::ptrdiff_t>(dy) * P + l] = line[dy];
+    }
+
+    // 前 n 行的行逆变换，只保留前 n 列
+    for (int dy = 0; dy < n; dy++) {
+      fft_complex *row = partial + static_cast<std::ptrdiff_t>(dy) * P;
+      _fft(plan, row, true);
+      for (int dx = 0; dx < n; dx++) {
+        double *s = sums + static_cast<std::ptrdiff_t>(block_num) * (dy * n + dx);
+        s[b1] = row[dx].real() * scale;
+        if (pair) s[b2] = row[dx].imag() * scale;
+      }
+    }
+  }
+}
+
+#endif
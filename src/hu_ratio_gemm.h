@@ -0,0 +1,75 @@
+#ifndef NPDS4CLIB_HU_RATIO_GEMM_H
+#define NPDS4CLIB_HU_RATIO_GEMM_H
+
+#ifndef USE_FC_LEN_T
+#define USE_FC_LEN_T
+#endif
+#include <R_ext/BLAS.h>
+#ifndef FCONE
+#define FCONE
+#endif
+
+#include <cmath>
+#include <cstddef>
+#include "block_view.h"
+
+// HU 比值的矩阵乘法形式
+// sum(nodule / |block + 0.1|) 是结节块与组织块倒数的内积；对一张切片，记倒数矩阵
+//   W[b, p] = 1 / |block_b[p] + 0.1|，维度为 block_num x split_size^2
+// 则所有组织块的比值之和为 W %*% nodule，多个结节块按列排成矩阵 N 后为一次 GEMM：W %*% N
+// W 只与扫描和切片有关，可以缓存后被同一对扫描上的所有结节复用
+// 像素 p = k * split_size + l 对应块内的 (k, l)，与 generate_lung_tissue_blocks_slice_cpp 的展平顺序相同
+// 先取倒数再相乘、由 BLAS 决定求和顺序，结果与逐个相除累加的 _hu_ratio_change_volume 只在舍入误差内一致
+
+// 第 m 张切片的倒数矩阵，写入 w[b + block_num * p]；layout 为体数据的内存布局
+// size 为组织块大小，特化版本（见 BlockSize）的块内循环次数固定
+template <class T, int S, int N>
+inline void _hu_ratio_reciprocal_slice(const T *volume, const VolumeLayout &layout, int m,
+                                       const BlockSize<S, N> &size, double *w) {
+  int split_size = size.split_size(), split_num = size.split_num();
+  int block_num = size.block_num();
+  SliceView<T> slice = volume_slice(volume, layout, m);
+  for (int i = 0; i < split_num; i++) {
+    for (int j = 0; j < split_num; j++) {
+      BlockView<T> block = slice.tissue_block(i, j, split_size);
+      int b = i * split_num + j;
+      for (int k = 0; k < split_size; k++) {
+        for (int l = 0; l < split_size; l++) {
+          w[b + static_cast<std::ptrdiff_t>(block_num) * (k * split_size + l)] =
+            1.0 / std::fabs(static_cast<double>(block(k, l)) + 0.1);
+        }
+      }
+    }
+  }
+}
+
+// 第 m 张切片上左上角为 (y_start, x_start) 的结节块，按像素顺序写入 nodule[p]
+template <class T, int S, int N>
+inline void _hu_ratio_nodule_column(const T *volume, const VolumeLayout &layout, int m,
+                                    int x_start, int y_start, const BlockSize<S, N> &size, double *nodule) {
+  int split_size = size.split_size();
+  SliceView<T> slice = volume_slice(volume, layout, m);
+  BlockView<T> block = slice.block(y_start, x_start, split_size);
+  for (int k = 0; k < split_size; k++) {
+    for (int l = 0; l < split_size; l++) {
+      nodule[k * split_size + l] = static_cast<double>(block(k, l));
+    }
+  }
+}
+
+// sums = w %*% nodules，w 为 block_num x n_pixels，nodules 为 n_pixels x n_nodules，均为列优先存储
+inline void _hu_ratio_gemm(const double *w, const double *nodules, int block_num, int n_pixels, int n_nodules,
+                           double *sums) {
+  const char trans = 'N';
+  const double one = 1.0, zero = 0.0;
+  if (n_nodules == 1) {
+    const int inc = 1;
+    F77_CALL(dgemv)(&trans, &block_num, &n_pixels, &one, w, &block_num, nodules, &inc,
+                    &zero, sums, &inc FCONE);
+  } else {
+    F77_CALL(dgemm)(&trans, &trans, &block_num, &n_nodules, &n_pixels, &one, w, &block_num,
+                    nodules, &n_pixels, &zero, sums, &block_num FCONE FCONE);
+  }
+}
+
+#endif
@@ -0,0 +1,129 @@
+#ifndef NPDS4CLIB_HU_RATIO_SIMD_H
+#define NPDS4CLIB_HU_RATIO_SIMD_H
+
+#include <cmath>
+#include <cstddef>
+
+// HU 比值的融合累加核：一次遍历同时累加基线和随访两期的 nodule / |block + 0.1|，不产生临时数组
+//   acc_1[t] += nod_1[t * nod_stride] / |blk_1[t] + 0.1|
+//   acc_2[t] += nod_2[t * nod_stride] / |blk_2[t] + 0.1|，t = 0, ..., n - 1
+// blk、acc 为连续内存；nod_stride 为 0 表示结节像素对所有 t 相同（广播），为 1 表示连续
+// 向量化只沿 t 方向展开，每个 acc[t] 的累加顺序与逐个标量计算完全相同，
+// 因此 AVX-512、AVX2、NEON 和标量版本的结果逐位一致
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define NPDS4CLIB_HU_RATIO_X86 1
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#define NPDS4CLIB_HU_RATIO_NEON 1
+#include <arm_neon.h>
+#endif
+
+typedef void (*HURatioAccumulateFn)(const double *, const double *, const double *, const double *,
+                                    std::ptrdiff_t, double *, double *, int);
+
+// 标量版本，也用于向量版本的尾部以及非 double 类型的输入
+template <class N, class B>
+inline void _hu_ratio_accumulate_scalar(const N *nod_1, const B *blk_1, const N *nod_2, const B *blk_2,
+                                        std::ptrdiff_t nod_stride, double *acc_1, double *acc_2, int n) {
+  for (int t = 0; t < n; t++) {
+    acc_1[t] += static_cast<double>(nod_1[t * nod_stride]) / std::fabs(static_cast<double>(blk_1[t]) + 0.1);
+    acc_2[t] += static_cast<double>(nod_2[t * nod_stride]) / std::fabs(static_cast<double>(blk_2[t]) + 0.1);
+  }
+}
+
+inline void _hu_ratio_accumulate_scalar_double(const double *nod_1, const double *blk_1,
+                                               const double *nod_2, const double *blk_2,
+                                               std::ptrdiff_t nod_stride, double *acc_1, double *acc_2, int n) {
+  _hu_ratio_accumulate_scalar(nod_1, blk_1, nod_2, blk_2, nod_stride, acc_1, acc_2, n);
+}
+
+#ifdef NPDS4CLIB_HU_RATIO_X86
+
+__attribute__((target("avx2")))
+inline void _hu_ratio_accumulate_avx2(const double *nod_1, const double *blk_1,
+                                      const double *nod_2, const double *blk_2,
+                                      std::ptrdiff_t nod_stride, double *acc_1, double *acc_2, int n) {
+  const __m256d offset = _mm256_set1_pd(0.1);
+  const __m256d sign = _mm256_set1_pd(-0.0);
+  int t = 0;
+  for (; t + 4 <= n; t += 4) {
+    __m256d n1 = nod_stride ? _mm256_loadu_pd(nod_1 + t) : _mm256_set1_pd(nod_1[0]);
+    __m256d n2 = nod_stride ? _mm256_loadu_pd(nod_2 + t) : _mm256_set1_pd(nod_2[0]);
+    __m256d d1 = _mm256_andnot_pd(sign, _mm256_add_pd(_mm256_loadu_pd(blk_1 + t), offset));
+    __m256d d2 = _mm256_andnot_pd(sign, _mm256_add_pd(_mm256_loadu_pd(blk_2 + t), offset));
+    _mm256_storeu_pd(acc_1 + t, _mm256_add_pd(_mm256_loadu_pd(acc_1 + t), _mm256_div_pd(n1, d1)));
+    _mm256_storeu_pd(acc_2 + t, _mm256_add_pd(_mm256_loadu_pd(acc_2 + t), _mm256_div_pd(n2, d2)));
+  }
+  _hu_ratio_accumulate_scalar(nod_1 + t * nod_stride, blk_1 + t, nod_2 + t * nod_stride, blk_2 + t,
+                              nod_stride, acc_1 + t, acc_2 + t, n - t);
+}
+
+__attribute__((target("avx512f")))
+inline void _hu_ratio_accumulate_avx512(const double *nod_1, const double *blk_1,
+                                        const double *nod_2, const double *blk_2,
+                                        std::ptrdiff_t nod_stride, double *acc_1, double *acc_2, int n) {
+  const __m512d offset = _mm512_set1_pd(0.1);
+  int t = 0;
+  for (; t + 8 <= n; t += 8) {
+    __m512d n1 = nod_stride ? _mm512_loadu_pd(nod_1 + t) : _mm512_set1_pd(nod_1[0]);
+    __m512d n2 = nod_stride ? _mm512_loadu_pd(nod_2 + t) : _mm512_set1_pd(nod_2[0]);
+    __m512d d1 = _mm512_abs_pd(_mm512_add_pd(_mm512_loadu_pd(blk_1 + t), offset));
+    __m512d d2 = _mm512_abs_pd(_mm512_add_pd(_mm512_loadu_pd(blk_2 + t), offset));
+    _mm512_storeu_pd(acc_1 + t, _mm512_add_pd(_mm512_loadu_pd(acc_1 + t), _mm512_div_pd(n1, d1)));
+    _mm512_storeu_pd(acc_2 + t, _mm512_add_pd(_mm512_loadu_pd(acc_2 + t), _mm512_div_pd(n2, d2)));
+  }
+  _hu_ratio_accumulate_scalar(nod_1 + t * nod_stride, blk_1 + t, nod_2 + t * nod_stride, blk_2 + t,
+                              nod_stride, acc_1 + t, acc_2 + t, n - t);
+}
+
+#endif
+
+#ifdef NPDS4CLIB_HU_RATIO_NEON
+
+inline void _hu_ratio_accumulate_neon(const double *nod_1, const double *blk_1,
+                                      const double *nod_2, const double *blk_2,
+                                      std::ptrdiff_t nod_stride, double *acc_1, double *acc_2, int n) {
+  const float64x2_t offset = vdupq_n_f64(0.1);
+  int t = 0;
+  for (; t + 2 <= n; t += 2) {
+    float64x2_t n1 = nod_stride ? vld1q_f64(nod_1 + t) : vdupq_n_f64(nod_1[0]);
+    float64x2_t n2 = nod_stride ? vld1q_f64(nod_2 + t) : vdupq_n_f64(nod_2[0]);
+    float64x2_t d1 = vabsq_f64(vaddq_f64(vld1q_f64(blk_1 + t), offset));
+    float64x2_t d2 = vabsq_f64(vaddq_f64(vld1q_f64(blk_2 + t), offset));
+    vst1q_f64(acc_1 + t, vaddq_f64(vld1q_f64(acc_1 + t), vdivq_f64(n1, d1)));
+    vst1q_f64(acc_2 + t, vaddq_f64(vld1q_f64(acc_2 + t), vdivq_f64(n2, d2)));
+  }
+  _hu_ratio_accumulate_scalar(nod_1 + t * nod_stride, blk_1 + t, nod_2 + t * nod_stride, blk_2 + t,
+                              nod_stride, acc_1 + t, acc_2 + t, n - t);
+}
+
+#endif
+
+// 运行时选择当前 CPU 支持的最宽指令集，只在第一次调用时检测
+inline HURatioAccumulateFn _hu_ratio_accumulate_select() {
+#if defined(NPDS4CLIB_HU_RATIO_X86)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) return _hu_ratio_accumulate_avx512;
+  if (__builtin_cpu_supports("avx2")) return _hu_ratio_accumulate_avx2;
+#elif defined(NPDS4CLIB_HU_RATIO_NEON)
+  return _hu_ratio_accumulate_neon;
+#endif
+  return _hu_ratio_accumulate_scalar_double;
+}
+
+inline void _hu_ratio_accumulate(const double *nod_1, const double *blk_1,
+                                 const double *nod_2, const double *blk_2,
+                                 std::ptrdiff_t nod_stride, double *acc_1, double *acc_2, int n) {
+  static const HURatioAccumulateFn fn = _hu_ratio_accumulate_select();
+  fn(nod_1, blk_1, nod_2, blk_2, nod_stride, acc_1, acc_2, n);
+}
+
+// 非 double 类型的输入走标量版本
+template <class N, class B>
+inline void _hu_ratio_accumulate(const N *nod_1, const B *blk_1, const N *nod_2, const B *blk_2,
+                                 std::ptrdiff_t nod_stride, double *acc_1, double *acc_2, int n) {
+  _hu_ratio_accumulate_scalar(nod_1, blk_1, nod_2, blk_2, nod_stride, acc_1, acc_2, n);
+}
+
+#endif
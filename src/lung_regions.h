@@ -0,0 +1,63 @@
+#ifndef NPDS4CLIB_LUNG_REGIONS_H
+#define NPDS4CLIB_LUNG_REGIONS_H
+
+#include <vector>
+#include <algorithm>
+#include "regionprops.h"
+
+// 肺区域筛选参数
+// top_k:      最多保留的区域个数（按面积从大到小，面积相同时标签小者优先）；< 0 表示不限
+// min_area:   区域的最小像素数
+// max_extent: 边界框行、列跨度的上限（跨度需严格小于该值）；<= 0 时按 512 图像上的 350 等比例换算
+// drop_border: 是否丢弃接触图像边界的区域
+struct LungRegionConfig {
+  int top_k;
+  int min_area;
+  int max_extent;
+  bool drop_border;
+};
+
+inline LungRegionConfig _default_lung_region_config() {
+  LungRegionConfig cfg = {2, 0, -1, true};
+  return cfg;
+}
+
+// 根据 props 生成按标签索引的保留表 keep（keep[label] 为 1 表示保留，keep[0] 恒为 0）
+// valid_regions 为工作区；返回保留下来的区域个数
+inline int _select_lung_regions(const std::vector<RegionProps> &props, XYPoint size,
+                                const LungRegionConfig &cfg, std::vector<char> &keep,
+                                std::vector<int> &valid_regions) {
+  int num_labels = static_cast<int>(props.size()) - 1;
+  int max_x = cfg.max_extent > 0 ? cfg.max_extent : 350 * size.x / 512;
+  int max_y = cfg.max_extent > 0 ? cfg.max_extent : 350 * size.y / 512;
+
+  // 筛选出有效的肺区域
+  valid_regions.clear();
+  for (int label = 1; label <= num_labels; label++) {
+    const RegionProps &p = props[label];
+    if (p.area == 0 || p.area < cfg.min_area) continue;
+    if (cfg.drop_border && p.on_border) continue;
+    if (p.x_max - p.x_min < max_x && p.y_max - p.y_min < max_y) {
+      valid_regions.push_back(label);
+    }
+  }
+
+  // 有效区域多于 top_k 个时保留面积最大的 top_k 个
+  if (cfg.top_k >= 0 && static_cast<int>(valid_regions.size()) > cfg.top_k) {
+    std::stable_sort(valid_regions.begin(), valid_regions.end(),
+                     [&props](int a, int b) { return props[a].area > props[b].area; });
+    valid_regions.resize(cfg.top_k);
+  }
+
+  keep.assign(num_labels + 1, 0);
+  for (int label : valid_regions) keep[label] = 1;
+  return static_cast<int>(valid_regions.size());
+}
+
+inline int _select_lung_regions(const std::vector<RegionProps> &props, XYPoint size,
+                                const LungRegionConfig &cfg, std::vector<char> &keep) {
+  std::vector<int> valid_regions;
+  return _select_lung_regions(props, size, cfg, keep, valid_regions);
+}
+
+#endif
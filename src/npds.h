@@ -0,0 +1,162 @@
+#ifndef NPDS4CLIB_NPDS_H
+#define NPDS4CLIB_NPDS_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "hu_ratio.h"
+#include "npds_workspace.h"
+#include "stage_timer.h"
+
+// 梯形积分，与 trapz_rcpp 的计算方式相同：
+// 对多边形 (x[0], 0), ..., (x[m-1], 0), (x[m-1], y[m-1]), ..., (x[0], y[0]) 使用鞋带公式
+// 第 i 个 y 值位于 y[i * y_stride]
+inline double _trapz(const double *x, const double *y, int m, std::ptrdiff_t y_stride = 1) {
+  if (m <= 0) return 0.0;
+
+  int n = 2 * m;
+  // xp、yp 为多边形顶点，按下标现算，不再单独分配数组
+  auto xp = [&](int i) { return i < m ? x[i] : x[n - 1 - i]; };
+  auto yp = [&](int i) { return i < m ? 0.0 : y[(n - 1 - i) * y_stride]; };
+
+  double p1 = 0.0, p2 = 0.0;
+  for (int i = 0; i < n - 1; ++i) {
+    p1 += xp(i) * yp(i + 1);
+    p2 += xp(i + 1) * yp(i);
+  }
+  p1 += xp(n - 1) * yp(0);
+  p2 += xp(0) * yp(n - 1);
+
+  return 0.5 * (p1 - p2);
+}
+
+// 由各切片的 NPDSt 得到 NPDS：
+// 正值均值的绝对值大于负值均值的绝对值时取最大值，否则取最小值
+inline double _npds_select(const double *npdst, int M) {
+  double max_npdst = npdst[0], min_npdst = npdst[0];
+  double sum_pos = 0.0, sum_neg = 0.0;
+  int n_pos = 0, n_neg = 0;
+  for (int m = 0; m < M; m++) {
+    double v = npdst[m];
+    if (v > max_npdst) max_npdst = v;
+    if (v < min_npdst) min_npdst = v;
+    if (v > 0) {
+      sum_pos += v;
+      n_pos++;
+    } else if (v < 0) {
+      sum_neg += v;
+      n_neg++;
+    }
+  }
+  double mean_pos = n_pos > 0 ? sum_pos / n_pos : 0.0;
+  double mean_neg = n_neg > 0 ? sum_neg / n_neg : 0.0;
+  return std::fabs(mean_pos) > std::fabs(mean_neg) ? max_npdst : min_npdst;
+}
+
+// 由所有切片的变化率 change[m * block_num + b] 逐切片生成检测结果，按切片并行
+// detection_matrix 为 NULL 时使用排序检测并把每张切片的积分写入 npdst，否则写出 c(R, M, block_num) 的检测矩阵
+// detection_list 维度为 c(M, R)；检测矩阵的元素类型 T 为 double 或 int8_t
+template <class T>
+inline void _hu_ratio_detection_slices(const double *change, int M, int block_num,
+                                       const double *threshold, int R,
+                                       T *detection_matrix, double *detection_list,
+                                       double *npdst, int nthreads) {
+#ifdef _OPENMP
+#pragma omp parallel num_threads(nthreads)
+#endif
+  {
+    std::vector<double> pos, neg;
+
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+    for (int m = 0; m < M; m++) {
+      const double *change_m = change + static_cast<std::ptrdiff_t>(m) * block_num;
+      if (detection_matrix == NULL) {
+        // detection_list[m, r] 位于 m + M * r
+        _hu_ratio_detection_sorted(change_m, block_num, threshold, R, detection_list + m, M, pos, neg);
+        npdst[m] = _trapz(threshold, detection_list + m, R, M);
+      } else {
+        // detection_matrix[r, m, b] 位于 r + R * m + R * M * b
+        _hu_ratio_detection(change_m, block_num, threshold, R,
+                            detection_matrix + static_cast<std::ptrdiff_t>(R) * m,
+                            1, static_cast<std::ptrdiff_t>(R) * M, detection_list + m, M);
+      }
+    }
+  }
+}
+
+// 整个 NPDS 计算：计算所有切片的 HU 比值变化率，再逐切片得到检测曲线及其积分 NPDSt，最后选出 NPDS
+// bf、af 为布局 volume 的体数据（[z, y, x] 或 NIfTI 原始的 [x, y, z]）；x_start、y_start 为结节块左上角的 0 起始下标
+// npdst 输出长度为 n_slices；返回 NPDS
+// 变化率按 (组织块, 切片段) 并行计算，检测曲线按切片并行计算，结果与 nthreads 无关
+// times 不为 NULL 时记录 hu_ratio_change、detection、selection 三步的墙钟时间和 CPU 时间
+// 变化率、检测列表与排序工作区取自 ws（至少有 nthreads 个线程工作区）；ws 为 NULL 时使用临时工作区
+// active 不为 NULL 时为稀疏评估（见 block_coverage.h）：只计算、检测 active[m * block_num + b] 不为 0 的组织块，
+// 检测列表以第 m 张切片参与的组织块数 n_active[m] 归一化；没有组织块参与的切片检测列表为 0
+template <class T>
+double _npds_volume(const T *bf, const T *af, const VolumeLayout &volume,
+                    int x_start, int y_start, int split_size, int split_num,
+                    const double *detection_lambda, int R, double *npdst, int nthreads = 1,
+                    StageTimes *times = NULL, NPDSWorkspace *ws = NULL,
+                    const uint8_t *active = NULL, int *n_active = NULL) {
+  int n_slices = volume.n_slices;
+  int block_num = split_num * split_num;
+  StageTimer timer = _stage_timer(times);
+  NPDSWorkspace local;
+  if (ws == NULL) ws = &local;
+  ws->reserve_threads(nthreads);
+  std::vector<double> &change = ws->change;
+  change.resize(static_cast<std::size_t>(n_slices) * block_num);
+
+  _hu_ratio_change_volume(bf, af, volume, x_start, y_start, split_size, split_num,
+                          change.data(), nthreads, active);
+  _stage_lap(timer, "hu_ratio_change");
+
+#ifdef _OPENMP
+#pragma omp parallel num_threads(nthreads)
+#endif
+  {
+    // 每个线程一份检测列表和排序工作区
+    NPDSThreadWork &work = ws->threads[_thread_id()];
+    std::vector<double> &detection_list = work.detection_list;
+    detection_list.resize(R);
+    work.pos.reserve(block_num);
+    work.neg.reserve(block_num);
+
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+    for (int m = 0; m < n_slices; m++) {
+      const double *change_m = change.data() + static_cast<std::ptrdiff_t>(m) * block_num;
+      int n_blocks = block_num;
+      if (active != NULL) {
+        // 参与的组织块的变化率收集到线程工作区
+        const uint8_t *active_m = active + static_cast<std::ptrdiff_t>(m) * block_num;
+        work.change.resize(block_num);
+        n_blocks = 0;
+        for (int b = 0; b < block_num; b++) {
+          if (active_m[b]) work.change[n_blocks++] = change_m[b];
+        }
+        change_m = work.change.data();
+        n_active[m] = n_blocks;
+      }
+      if (n_blocks > 0) {
+        _hu_ratio_detection_sorted(change_m, n_blocks, detection_lambda, R, detection_list.data(), 1,
+                                   work.pos, work.neg);
+      } else {
+        std::fill(detection_list.begin(), detection_list.end(), 0.0);
+      }
+      npdst[m] = _trapz(detection_lambda, detection_list.data(), R);
+    }
+  }
+  _stage_lap(timer, "detection");
+
+  double npds = _npds_select(npdst, n_slices);
+  _stage_lap(timer, "selection");
+  return npds;
+}
+
+#endif
@@ -0,0 +1,220 @@
+#include <Rcpp.h>
+#include <cmath>
+#include <vector>
+#include "hu_ratio_gemm.h"
+#include "npds.h"
+#include "typed_volume.h"
+#include "volume_utils.h"
+using namespace Rcpp;
+
+// 按存储类型计算所有切片的倒数矩阵
+struct ReciprocalTask {
+  VolumeLayout layout;
+  int split_size, split_num;
+  double *w;
+  int nthreads;
+
+  template <class T>
+  void operator()(const T *volume) {
+    dispatch_block_size(split_size, split_num, *this, volume, volume);
+  }
+
+  template <class T, int S, int N>
+  void run(const T *volume, const T *, const BlockSize<S, N> &size) {
+    std::ptrdiff_t slice_size = static_cast<std::ptrdiff_t>(size.block_num()) * size.n_pixels();
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(nthreads) schedule(static)
+#endif
+    for (int m = 0; m < layout.n_slices; m++) {
+      _hu_ratio_reciprocal_slice(volume, layout, m, size, w + m * slice_size);
+    }
+  }
+};
+
+// 按存储类型对一批结节逐切片做 GEMM，得到每个结节每张切片的 NPDSt
+// GEMM 在 OpenMP 并行区域之外调用：链接多线程 BLAS 时由 BLAS 自己使用多个线程，不与 OpenMP 线程叠加；
+// 只有取结节块和按结节计算检测列表的部分由 OpenMP 并行
+struct BatchTask {
+  VolumeLayout layout;
+  int split_size, split_num;
+  const double *w[2];
+  const int *x_start, *y_start;
+  int n_nodules;
+  const double *detection_lambda;
+  int R;
+  double *npdst;  // npdst[m + n_slices * q]
+  int nthreads;
+  NPDSWorkspace *ws;
+
+  template <class T>
+  void operator()(const T *bf, const T *af) {
+    dispatch_block_size(split_size, split_num, *this, bf, af);
+  }
+
+  template <class T, int S, int N>
+  void run(const T *bf, const T *af, const BlockSize<S, N> &size) {
+    int n_slices = layout.n_slices;
+    int block_num = size.block_num();
+    int n_pixels = size.n_pixels();
+    std::ptrdiff_t slice_size = static_cast<std::ptrdiff_t>(block_num) * n_pixels;
+    const T *volume[2] = {bf, af};
+
+    // 所有线程共用的结节矩阵与乘积，取自第一个线程的工作区
+    NPDSThreadWork &shared = ws->threads[0];
+    std::vector<double> &nodules = shared.nodules;
+    std::vector<double> *sums = shared.sums;
+    nodules.resize(static_cast<std::size_t>(n_pixels) * n_nodules * 2);
+    sums[0].resize(static_cast<std::size_t>(block_num) * n_nodules);
+    sums[1].resize(static_cast<std::size_t>(block_num) * n_nodules);
+    double *columns[2] = {nodules.data(), nodules.data() + static_cast<std::ptrdiff_t>(n_pixels) * n_nodules};
+
+    for (int m = 0; m < n_slices; m++) {
+      // 两期的结节块按列排成矩阵
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(nthreads) schedule(static)
+#endif
+      for (int k = 0; k < 2 * n_nodules; k++) {
+        int s = k / n_nodules, q = k % n_nodules;
+        _hu_ratio_nodule_column(volume[s], layout, m, x_start[q], y_start[q], size,
+                                columns[s] + static_cast<std::ptrdiff_t>(n_pixels) * q);
+      }
+
+      for (int s = 0; s < 2; s++) {
+        _hu_ratio_gemm(w[s] + m * slice_size, columns[s], block_num, n_pixels, n_nodules, sums[s].data());
+      }
+
+      // 每个线程一份检测工作区
+#ifdef _OPENMP
+#pragma omp parallel num_threads(nthreads)
+#endif
+      {
+        NPDSThreadWork &work = ws->threads[_thread_id()];
+        std::vector<double> &change = work.change, &detection_list = work.detection_list;
+        std::vector<double> &pos = work.pos, &neg = work.neg;
+        change.resize(block_num);
+        detection_list.resize(R);
+
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+        for (int q = 0; q < n_nodules; q++) {
+          const double *sum_1 = sums[0].data() + static_cast<std::ptrdiff_t>(block_num) * q;
+          const double *sum_2 = sums[1].data() + static_cast<std::ptrdiff_t>(block_num) * q;
+          for (int b = 0; b < block_num; b++) {
+            double mean_ratio_1 = sum_1[b] / n_pixels;
+            double mean_ratio_2 = sum_2[b] / n_pixels;
+            change[b] = (mean_ratio_2 - mean_ratio_1) / std::fabs(mean_ratio_1);
+          }
+          _hu_ratio_detection_sorted(change.data(), block_num, detection_lambda, R,
+                                     detection_list.data(), 1, pos, neg);
+          npdst[m + static_cast<std::ptrdiff_t>(n_slices) * q] = _trapz(detection_lambda, detection_list.data(), R);
+        }
+      }
+    }
+  }
+};
+
+// 子区域每张切片的组织块倒数矩阵 1 / |block + 0.1|，可以缓存后传给 npds_batch_cpp
+// 返回维度为 c(block_num, split_size^2, M) 的 double 数组，第 m 张切片为 block_num x split_size^2 的矩阵
+// 子区域可以是 double 数组，也可以是 npds_storage() 生成的 int16 / float32 体数据，布局可以是 [z, y, x] 或 NIfTI 原始布局
+// [[Rcpp::export]]
+NumericVector hu_ratio_reciprocal_cpp(SEXP sub_image, int split_size, int image_size, int nthreads = 1) {
+  TypedVolume v = typed_volume(sub_image, "hu_ratio_reciprocal_cpp");
+  require_image_storage(v, "hu_ratio_reciprocal_cpp");
+  int dims[3] = {v.n_slices, v.nrow, v.ncol};
+  // 结节块放在 (0, 0) 处只为复用维度检查
+  int split_num = check_block_geometry(dims, dims, 0, 0, split_size, image_size, "hu_ratio_reciprocal_cpp");
+
+  if (nthreads < 1) nthreads = 1;
+#ifndef _OPENMP
+  nthreads = 1;
+#endif
+
+  int block_num = split_num * split_num;
+  int n_pixels = split_size * split_size;
+  NumericVector w(static_cast<R_xlen_t>(block_num) * n_pixels * v.n_slices);
+  w.attr("dim") = IntegerVector::create(block_num, n_pixels, v.n_slices);
+
+  ReciprocalTask task = {volume_layout(v), split_size, split_num, REAL(w), nthreads};
+  dispatch_storage(v, task);
+  return w;
+}
+
+// 同一对子区域上一批结节的 NPDS
+// voxel_coords 每行为一个结节中心 c(x, y, ...)，结节块位置与 npds_calculate_cpp 中相同
+// bf_reciprocal、af_reciprocal 为 hu_ratio_reciprocal_cpp 的结果，所有结节共用；
+// 每张切片上所有结节的比值之和由一次 GEMM（只有一个结节时为 GEMV）得到，不再为每个结节重新遍历组织块
+// nthreads 只用于 OpenMP 部分，GEMM 的线程数由所链接的 BLAS 决定
+// 返回每个结节的 NPDS，以及维度为 c(M, n_nodules) 的 NPDSt
+// 结果与 npds_calculate_cpp 只在舍入误差内一致（见 hu_ratio_gemm.h）
+// workspace 为 npds_workspace() 创建的工作区时，每个线程的结节矩阵、乘积和检测工作区取自其中
+// [[Rcpp::export]]
+List npds_batch_cpp(SEXP bf_sub_image,
+                    SEXP af_sub_image,
+                    NumericVector bf_reciprocal,
+                    NumericVector af_reciprocal,
+                    NumericMatrix voxel_coords,
+                    int split_size,
+                    int image_size,
+                    NumericVector detection_lambda,
+                    int nthreads = 1,
+                    SEXP workspace = R_NilValue) {
+  const char *caller = "npds_batch_cpp";
+  if (voxel_coords.ncol() < 2) {
+    stop("npds_batch_cpp: voxel_coords must have at least two columns (x and y).");
+  }
+  if (detection_lambda.size() == 0) {
+    stop("npds_batch_cpp: detection_lambda must not be empty.");
+  }
+
+  TypedVolume bf = typed_volume(bf_sub_image, caller);
+  TypedVolume af = typed_volume(af_sub_image, caller);
+  int bf_dims[3] = {bf.n_slices, bf.nrow, bf.ncol};
+  int af_dims[3] = {af.n_slices, af.nrow, af.ncol};
+  int M = bf.n_slices;
+  if (M == 0) {
+    stop("npds_batch_cpp: bf_sub_image has no slices.");
+  }
+
+  // 结节块左上角（0 起始下标）
+  int n_nodules = voxel_coords.nrow();
+  std::vector<int> x_start(n_nodules), y_start(n_nodules);
+  int split_num = image_size / split_size;
+  for (int q = 0; q < n_nodules; q++) {
+    x_start[q] = static_cast<int>(std::floor(voxel_coords(q, 0) - split_size / 2.0)) - 1;
+    y_start[q] = static_cast<int>(std::floor(voxel_coords(q, 1) - split_size / 2.0)) - 1;
+    split_num = check_block_geometry(bf_dims, af_dims, x_start[q], y_start[q], split_size, image_size, caller);
+  }
+
+  int block_num = split_num * split_num;
+  R_xlen_t w_size = static_cast<R_xlen_t>(block_num) * split_size * split_size * M;
+  if (bf_reciprocal.size() != w_size || af_reciprocal.size() != w_size) {
+    stop("npds_batch_cpp: bf_reciprocal and af_reciprocal do not match the sub-images; "
+         "recompute them with hu_ratio_reciprocal_cpp.");
+  }
+
+  if (nthreads < 1) nthreads = 1;
+#ifndef _OPENMP
+  nthreads = 1;
+#endif
+
+  NPDSWorkspace local;
+  NPDSWorkspace *ws = workspace_arg(workspace, local, nthreads, caller);
+
+  NumericMatrix NPDSt(M, n_nodules);
+  NumericVector NPDS(n_nodules);
+  if (n_nodules > 0) {
+    BatchTask task = {volume_layout(bf), split_size, split_num,
+                      {REAL(bf_reciprocal), REAL(af_reciprocal)},
+                      x_start.data(), y_start.data(), n_nodules,
+                      REAL(detection_lambda), static_cast<int>(detection_lambda.size()),
+                      REAL(NPDSt), nthreads, ws};
+    dispatch_storage_pair(bf, af, task, caller);
+  }
+  for (int q = 0; q < n_nodules; q++) {
+    NPDS[q] = _npds_select(REAL(NPDSt) + static_cast<std::ptrdiff_t>(M) * q, M);
+  }
+
+  return List::create(Named("NPDS") = NPDS,
+                      Named("NPDSt") = NPDSt);
+}
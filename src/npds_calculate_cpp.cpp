@@ -0,0 +1,91 @@
+#include <Rcpp.h>
+#include "npds_core.h"
+#include "typed_volume.h"
+#include "volume_utils.h"
+using namespace Rcpp;
+
+// 一次调用完成 NPDS 计算：npds_core.h 中 npds::score 的 R 绑定，子区域与掩膜直接传递 R 对象的数据
+// voxel_coord 为结节中心 c(x, y, z)，结节块位置与 generate_nodule_block_listC 中相同
+// 返回 NPDS 以及每张切片的 NPDSt
+// 子区域可以是 double 数组，也可以是 npds_storage() 生成的 int16 / float32 体数据
+// 带 npds_layout = "xyz" 属性的子区域（npds_native()）按 NIfTI 原始布局通过步长读取，不需要 aperm
+// nthreads 为 OpenMP 线程数，结果与线程数无关
+// profile 为 TRUE 时另外返回 profile：C++ 中每一步的 step、wall_s（墙钟时间）和 cpu_s（所有线程的 CPU 时间）
+// workspace 为 npds_workspace() 创建的工作区时，变化率与检测的临时缓冲区取自其中，多次调用之间复用
+// 给出 bf_mask、af_mask（get_segmented_lungs 的肺掩膜，维度、布局与子区域相同）时为稀疏评估：
+// 每张切片只计算与检测两期肺像素比例都不小于 min_coverage 的组织块，并另外返回每张切片参与的组织块数 block_num
+// [[Rcpp::export]]
+List npds_calculate_cpp(SEXP bf_sub_image,
+                        SEXP af_sub_image,
+                        NumericVector voxel_coord,
+                        int split_size,
+                        int image_size,
+                        NumericVector detection_lambda,
+                        int nthreads = 1,
+                        bool profile = false,
+                        SEXP workspace = R_NilValue,
+                        SEXP bf_mask = R_NilValue,
+                        SEXP af_mask = R_NilValue,
+                        double min_coverage = 0.0) {
+  if (voxel_coord.size() < 2) {
+    stop("npds_calculate_cpp: voxel_coord must contain at least x and y.");
+  }
+  if (detection_lambda.size() == 0) {
+    stop("npds_calculate_cpp: detection_lambda must not be empty.");
+  }
+
+  TypedVolume bf = typed_volume(bf_sub_image, "npds_calculate_cpp");
+  TypedVolume af = typed_volume(af_sub_image, "npds_calculate_cpp");
+  int M = bf.n_slices;
+
+  npds::ScoreOptions options;
+  options.nthreads = nthreads;
+  NPDSWorkspace local;
+  options.workspace = workspace_arg(workspace, local, nthreads, "npds_calculate_cpp");
+
+  // 稀疏评估：两期肺掩膜
+  bool sparse = !Rf_isNull(bf_mask) || !Rf_isNull(af_mask);
+  TypedVolume bf_m, af_m;
+  if (sparse) {
+    if (Rf_isNull(bf_mask) || Rf_isNull(af_mask)) {
+      stop("npds_calculate_cpp: both bf_mask and af_mask are required for the sparse evaluation.");
+    }
+    bf_m = typed_volume(bf_mask, "npds_calculate_cpp");
+    af_m = typed_volume(af_mask, "npds_calculate_cpp");
+    options.bf_mask = &bf_m;
+    options.af_mask = &af_m;
+    options.min_coverage = min_coverage;
+  }
+
+  NumericVector NPDSt(M);
+  IntegerVector block_num(sparse ? M : 0);
+  StageTimes times;
+  options.times = profile ? &times : NULL;
+  double npds = npds::score(bf, af, voxel_coord[0], voxel_coord[1], split_size, image_size,
+                            REAL(detection_lambda), static_cast<int>(detection_lambda.size()), REAL(NPDSt),
+                            sparse ? INTEGER(block_num) : NULL, options);
+
+  if (!profile) {
+    if (sparse) {
+      return List::create(Named("NPDS") = npds,
+                          Named("NPDSt") = NPDSt,
+                          Named("block_num") = block_num);
+    }
+    return List::create(Named("NPDS") = npds,
+                        Named("NPDSt") = NPDSt);
+  }
+  CharacterVector step(times.n);
+  NumericVector wall(times.n), cpu(times.n);
+  for (int k = 0; k < times.n; k++) {
+    step[k] = times.name[k];
+    wall[k] = times.wall[k];
+    cpu[k] = times.cpu[k];
+  }
+  List result = List::create(Named("NPDS") = npds,
+                             Named("NPDSt") = NPDSt,
+                             Named("profile") = List::create(Named("step") = step,
+                                                             Named("wall_s") = wall,
+                                                             Named("cpu_s") = cpu));
+  if (sparse) result["block_num"] = block_num;
+  return result;
+}
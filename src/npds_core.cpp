@@ -0,0 +1,427 @@
+#include "npds_core.h"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include "bitmask.h"
+#include "block_coverage.h"
+#include "bwlabel.h"
+#include "lung_regions.h"
+#include "npds.h"
+#include "segment_lung_slice.h"
+
+// 核心库的实现；不包含 R 的头文件，可以在 R 之外单独编译
+
+namespace npds {
+
+static Volume make_volume(StorageType type, const void *data, int n_slices, int nrow, int ncol, bool xyz) {
+  Volume v;
+  v.type = type;
+  v.data = const_cast<void *>(data);
+  v.n_slices = n_slices;
+  v.nrow = nrow;
+  v.ncol = ncol;
+  v.n = static_cast<std::ptrdiff_t>(n_slices) * nrow * ncol;
+  v.xyz = xyz;
+  return v;
+}
+
+Volume volume(const double *data, int n_slices, int nrow, int ncol, bool xyz) {
+  return make_volume(STORAGE_DOUBLE, data, n_slices, nrow, ncol, xyz);
+}
+
+Volume volume(const int16_t *data, int n_slices, int nrow, int ncol, bool xyz) {
+  return make_volume(STORAGE_INT16, data, n_slices, nrow, ncol, xyz);
+}
+
+Volume volume(const float *data, int n_slices, int nrow, int ncol, bool xyz) {
+  return make_volume(STORAGE_FLOAT32, data, n_slices, nrow, ncol, xyz);
+}
+
+Volume volume(const uint8_t *data, int n_slices, int nrow, int ncol, bool xyz) {
+  return make_volume(STORAGE_UINT8, data, n_slices, nrow, ncol, xyz);
+}
+
+static int thread_count(int nthreads) {
+  if (nthreads < 1) nthreads = 1;
+#ifndef _OPENMP
+  nthreads = 1;
+#endif
+  return nthreads;
+}
+
+static LungRegionConfig region_config(const SegmentOptions &options) {
+  LungRegionConfig cfg = {options.top_k, options.min_area, options.max_extent, options.drop_border};
+  return cfg;
+}
+
+// ---- 肺分割 ----
+
+int bwlabel(const double *x, int nrow, int ncol, int *labels, int connectivity) {
+  XYPoint size = {nrow, ncol};
+  return _bwlabel(x, labels, size, connectivity);
+}
+
+bool regionprops(const int *labels, int num_labels, int nrow, int ncol, int buffer_size,
+                 std::vector<RegionProps> &props) {
+  XYPoint size = {nrow, ncol};
+  return _regionprops(labels, num_labels, size, buffer_size, props);
+}
+
+int select_lung_regions(const std::vector<RegionProps> &props, int nrow, int ncol, const SegmentOptions &options,
+                        std::vector<char> &keep, std::vector<int> &valid_regions) {
+  XYPoint size = {nrow, ncol};
+  return _select_lung_regions(props, size, region_config(options), keep, valid_regions);
+}
+
+// 非零像素打包为位掩膜，与边界相连的区域由掩膜上按字的扫描线扩展得到，不做连通区域标记，
+// 结果与依次做 bwlabel、收集边界上的标签、清除这些标签的像素相同
+void clear_border(double *x, int nrow, int ncol, int buffer_size, double bgval, int connectivity,
+                  LungSliceWork &work) {
+  // 设置扩展范围
+  int ext = buffer_size + 1;
+  XYPoint size = {nrow, ncol};
+
+  BitMask &fg = work.fg;
+  BitMask &border = work.border;
+  _bitmask_nonzero(x, size, fg);
+
+  // 边界范围内有背景像素时背景（标签 0）也与边界相连，所有背景像素同样设为 bgval
+  _bitmask_frame(nrow, ncol, ext, border);
+  _bitmask_andnot(border, fg, border);
+  bool background_on_border = _bitmask_count(border) > 0;
+
+  // 与边界相连的前景区域
+  _bitmask_border_regions(fg, ext, connectivity, border);
+
+  // 需要清除的像素按字逐个取出置位的位
+  for (int j = 0; j < ncol; j++) {
+    const uint64_t *f = fg.column(j);
+    const uint64_t *b = border.column(j);
+    for (int w = 0; w < fg.words; w++) {
+      uint64_t clear = b[w];
+      if (background_on_border) clear |= ~f[w] & fg.valid(w);
+      while (clear) {
+        int i = 64 * w + _bit_ctz(clear);
+        x[i + static_cast<std::ptrdiff_t>(j) * nrow] = bgval;
+        clear &= clear - 1;
+      }
+    }
+  }
+}
+
+int segment_lung_slice(const double *im, int nrow, int ncol, double *out, int *binary,
+                       const SegmentOptions &options, LungSliceWork &work) {
+  XYPoint size = {nrow, ncol};
+  return _segment_lung_slice(im, out, binary, work, size, 1, nrow, options.threshold, options.buffer_size,
+                             options.connectivity, region_config(options));
+}
+
+// 对体数据中的第 m 张切片做肺分割，按存储类型选择模板实例
+// out 与 in 同类型，binary 为 mask_storage(in.type) 对应的类型
+static void segment_typed_slice(const Volume &in, void *out, void *binary, int m, LungSliceWork &work,
+                                const SegmentOptions &options, const LungRegionConfig &cfg) {
+  VolumeLayout layout = volume_layout(in);
+  std::ptrdiff_t row_stride = layout.row_stride;
+  std::ptrdiff_t col_stride = layout.col_stride;
+  std::ptrdiff_t offset = m * layout.slice_stride;
+  XYPoint size = {in.nrow, in.ncol};
+
+  switch (in.type) {
+  case STORAGE_INT16:
+    _segment_lung_slice(static_cast<const int16_t *>(in.data) + offset, static_cast<int16_t *>(out) + offset,
+                        static_cast<uint8_t *>(binary) + offset, work, size, row_stride, col_stride,
+                        options.threshold, options.buffer_size, options.connectivity, cfg);
+    break;
+  case STORAGE_FLOAT32:
+    _segment_lung_slice(static_cast<const float *>(in.data) + offset, static_cast<float *>(out) + offset,
+                        static_cast<uint8_t *>(binary) + offset, work, size, row_stride, col_stride,
+                        options.threshold, options.buffer_size, options.connectivity, cfg);
+    break;
+  default:
+    _segment_lung_slice(static_cast<const double *>(in.data) + offset, static_cast<double *>(out) + offset,
+                        static_cast<int *>(binary) + offset, work, size, row_stride, col_stride,
+                        options.threshold, options.buffer_size, options.connectivity, cfg);
+    break;
+  }
+}
+
+void segment_lungs(const Volume *in, void *const *out, void *const *binary, int n_volumes,
+                   const SegmentOptions &options, int nthreads, NPDSWorkspace *workspace) {
+  for (int s = 0; s < n_volumes; s++) {
+    require_image_storage(in[s], "npds::segment_lungs");
+  }
+
+  // 所有体数据的切片合并为一个任务列表，切片之间互不依赖
+  std::vector<int> first(n_volumes + 1, 0);
+  for (int s = 0; s < n_volumes; s++) first[s + 1] = first[s] + in[s].n_slices;
+  int n_tasks = first[n_volumes];
+
+  LungRegionConfig cfg = region_config(options);
+  nthreads = thread_count(nthreads);
+
+  // 每个线程一份标记与区域统计工作区，在并行区之外准备
+  NPDSWorkspace local;
+  NPDSWorkspace *ws = workspace != NULL ? workspace : &local;
+  ws->reserve_threads(nthreads);
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(nthreads) schedule(dynamic)
+#endif
+  for (int task = 0; task < n_tasks; task++) {
+    int s = static_cast<int>(std::upper_bound(first.begin(), first.end(), task) - first.begin()) - 1;
+    segment_typed_slice(in[s], out[s], binary[s], task - first[s], ws->threads[_thread_id()].lung, options, cfg);
+  }
+}
+
+// ---- 组织块与 NPDS ----
+
+// 按组织块大小把切片的每个小块展平：第 split_index 个小块的第 pixel_index 个像素
+// 写入 result[split_index + block_num * pixel_index]，即 block_num x split_size^2 的列优先矩阵
+struct TissueBlocksTask {
+  SliceView<double> slice;
+  double *result;
+
+  template <int S, int N>
+  void operator()(const BlockSize<S, N> &size) {
+    int split_size = size.split_size(), num_splits = size.split_num();
+    std::ptrdiff_t block_num = size.block_num();
+
+    // 遍历切片的每个小块
+    for (int i = 0; i < num_splits; i++) {
+      for (int j = 0; j < num_splits; j++) {
+
+        int split_index = i * num_splits + j;
+        BlockView<double> block = slice.tissue_block(i, j, split_size);
+
+        // 将子块展平并赋值到结果矩阵的相应位置
+        for (int k = 0; k < split_size; k++) {
+          for (int l = 0; l < split_size; l++) {
+            int pixel_index = k * split_size + l;
+            result[split_index + block_num * pixel_index] = block(k, l);
+          }
+        }
+      }
+    }
+  }
+};
+
+void lung_tissue_blocks(const double *slice, int nrow, int ncol, int image_size, int split_size, double *result) {
+  if (split_size <= 0) {
+    npds_stop("npds::lung_tissue_blocks: split_size must be positive.");
+  }
+  int num_splits = image_size / split_size;  // 切分数
+
+  // 直接从切片视图中读取每个小块，不再经过临时子矩阵
+  SliceView<double> view = {slice, nrow, ncol, 1, nrow};
+
+  // image_size = 512、split_size = 32 或 64 时使用编译期特化的版本
+  TissueBlocksTask task = {view, result};
+  dispatch_block_size(split_size, num_splits, task);
+}
+
+std::vector<double> detection_lambda() {
+  std::vector<double> lambda(100);
+  for (int k = 0; k < 100; k++) lambda[k] = (k + 1) / 100.0;
+  return lambda;
+}
+
+// 按存储类型调用 _npds_volume
+struct NPDSVolumeTask {
+  VolumeLayout volume;
+  int x_start, y_start, split_size, split_num;
+  const double *detection_lambda;
+  int R;
+  double *npdst;
+  int nthreads;
+  StageTimes *times;
+  NPDSWorkspace *ws;
+  const uint8_t *active;
+  int *n_active;
+  double npds;
+
+  template <class T>
+  void operator()(const T *bf, const T *af) {
+    npds = _npds_volume(bf, af, volume, x_start, y_start, split_size, split_num,
+                        detection_lambda, R, npdst, nthreads, times, ws, active, n_active);
+  }
+};
+
+// HU 比值检测、逐切片梯形积分以及 NPDS 的选取，不生成组织块数组、结节块列表和检测矩阵
+// 结节块位置与 generate_nodule_block_listC 中相同
+double score(const Volume &bf, const Volume &af, double x, double y, int split_size, int image_size,
+             const double *detection_lambda, int R, double *npdst, int *block_num,
+             const ScoreOptions &options) {
+  const char *caller = "npds::score";
+  if (R <= 0) {
+    npds_stop("npds::score: detection_lambda must not be empty.");
+  }
+
+  // 结节块左上角（0 起始下标）
+  int x_start = static_cast<int>(std::floor(x - split_size / 2.0)) - 1;
+  int y_start = static_cast<int>(std::floor(y - split_size / 2.0)) - 1;
+
+  int bf_dims[3] = {bf.n_slices, bf.nrow, bf.ncol};
+  int af_dims[3] = {af.n_slices, af.nrow, af.ncol};
+  int split_num = check_block_geometry(bf_dims, af_dims, x_start, y_start, split_size, image_size, caller);
+  int M = bf.n_slices;
+  if (M == 0) {
+    npds_stop("npds::score: bf_sub_image has no slices.");
+  }
+
+  int nthreads = thread_count(options.nthreads);
+  NPDSWorkspace local;
+  NPDSWorkspace *ws = options.workspace != NULL ? options.workspace : &local;
+  ws->reserve_threads(nthreads);
+
+  // 稀疏评估：由肺掩膜得到参与计算的组织块
+  bool sparse = options.bf_mask != NULL || options.af_mask != NULL;
+  std::vector<int> n_active;
+  if (sparse) {
+    if (options.bf_mask == NULL || options.af_mask == NULL) {
+      npds_stop("npds::score: both bf_mask and af_mask are required for the sparse evaluation.");
+    }
+    if (!(options.min_coverage >= 0.0 && options.min_coverage <= 1.0)) {
+      npds_stop("npds::score: min_coverage must lie in [0, 1].");
+    }
+    const Volume &bf_m = *options.bf_mask;
+    const Volume &af_m = *options.af_mask;
+    if (bf_m.n_slices != M || bf_m.nrow != bf.nrow || bf_m.ncol != bf.ncol || bf_m.xyz != bf.xyz ||
+        af_m.n_slices != M || af_m.nrow != bf.nrow || af_m.ncol != bf.ncol || af_m.xyz != bf.xyz) {
+      npds_stop("npds::score: the lung masks must have the dimensions and layout of the sub-images.");
+    }
+    ws->active.resize(static_cast<std::size_t>(M) * split_num * split_num);
+    BlockCoverageTask coverage = {volume_layout(bf_m), split_size, split_num, options.min_coverage,
+                                  ws->active.data(), nthreads};
+    dispatch_storage_pair(bf_m, af_m, coverage, caller);
+    if (block_num == NULL) {
+      n_active.resize(M);
+      block_num = n_active.data();
+    }
+  }
+
+  NPDSVolumeTask task = {volume_layout(bf), x_start, y_start, split_size, split_num,
+                         detection_lambda, R, npdst, nthreads, options.times, ws,
+                         sparse ? ws->active.data() : NULL, sparse ? block_num : NULL, 0.0};
+  dispatch_storage_pair(bf, af, task, caller);
+  return task.npds;
+}
+
+double trapz(const double *x, const double *y, int n) {
+  return _trapz(x, y, n);
+}
+
+// ---- 假设检验 ----
+
+// 按逗号切分 CSV 的一行，支持双引号包围的字段（字段内的 "" 表示一个引号）
+static void split_csv_line(const std::string &line, std::vector<std::string> &fields) {
+  fields.clear();
+  std::string field;
+  bool quoted = false;
+  for (std::size_t k = 0; k < line.size(); k++) {
+    char c = line[k];
+    if (quoted) {
+      if (c == '"' && k + 1 < line.size() && line[k + 1] == '"') {
+        field += '"';
+        k++;
+      } else if (c == '"') {
+        quoted = false;
+      } else {
+        field += c;
+      }
+    } else if (c == '"') {
+      quoted = true;
+    } else if (c == ',') {
+      fields.push_back(field);
+      field.clear();
+    } else if (c != '\r') {
+      field += c;
+    }
+  }
+  fields.push_back(field);
+}
+
+// 只解析这一列，不构造整张表；非数值的字段视为错误
+std::vector<double> read_sorted_column(const std::string &path, const std::string &column) {
+  std::ifstream in(path.c_str());
+  if (!in) {
+    npds_stop("npds::read_sorted_column: cannot read " + path + ".");
+  }
+  std::string line;
+  std::vector<std::string> fields;
+  if (!std::getline(in, line)) {
+    npds_stop("npds::read_sorted_column: " + path + " is empty.");
+  }
+  split_csv_line(line, fields);
+  std::size_t index = fields.size();
+  for (std::size_t k = 0; k < fields.size(); k++) {
+    if (fields[k] == column) {
+      index = k;
+      break;
+    }
+  }
+  if (index == fields.size()) {
+    npds_stop("npds::read_sorted_column: column " + column + " not found in " + path + ".");
+  }
+
+  std::vector<double> values;
+  while (std::getline(in, line)) {
+    if (line.empty() || line == "\r") continue;
+    split_csv_line(line, fields);
+    if (index >= fields.size()) {
+      npds_stop("npds::read_sorted_column: a row of " + path + " has too few fields.");
+    }
+    const char *begin = fields[index].c_str();
+    char *end = NULL;
+    errno = 0;
+    double value = std::strtod(begin, &end);
+    if (end == begin || *end != '\0' || errno == ERANGE || value != value) {
+      npds_stop("npds::read_sorted_column: non-numeric value \"" + fields[index] + "\" in " + path + ".");
+    }
+    values.push_back(value);
+  }
+
+  std::sort(values.begin(), values.end());
+  return values;
+}
+
+// 每次查询一次二分查找
+double exceedance(const double *sorted, std::ptrdiff_t n, double x) {
+  if (n == 0 || x != x) return std::numeric_limits<double>::quiet_NaN();
+  std::ptrdiff_t above = (sorted + n) - std::upper_bound(sorted, sorted + n, x);
+  return static_cast<double>(above) / static_cast<double>(n);
+}
+
+int clinv_group(double diameter_mm) {
+  if (diameter_mm != diameter_mm) return 0;
+  return 1 + (diameter_mm > 5) + (diameter_mm > 10) + (diameter_mm > 15);
+}
+
+TestResult hypothesis_test(double npds, double diameter_mm, const double percentiles[4],
+                           const double *const reference[4], const std::ptrdiff_t reference_size[4]) {
+  TestResult result;
+  result.group = clinv_group(diameter_mm);
+  if (result.group == 0 || npds != npds) {
+    result.progression = -1;
+    result.p_value = std::numeric_limits<double>::quiet_NaN();
+    return result;
+  }
+  result.progression = npds > percentiles[result.group - 1];
+  result.p_value = exceedance(reference[result.group - 1], reference_size[result.group - 1], npds);
+  return result;
+}
+
+TestResult hypothesis_test(double npds, double diameter_mm, const double percentiles[4],
+                           const std::vector<double> reference[4]) {
+  const double *data[4];
+  std::ptrdiff_t size[4];
+  for (int g = 0; g < 4; g++) {
+    data[g] = reference[g].data();
+    size[g] = static_cast<std::ptrdiff_t>(reference[g].size());
+  }
+  return hypothesis_test(npds, diameter_mm, percentiles, data, size);
+}
+
+}  // namespace npds
@@ -0,0 +1,134 @@
+#ifndef NPDS4CLIB_NPDS_CORE_H
+#define NPDS4CLIB_NPDS_CORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "npds_workspace.h"
+#include "regionprops.h"
+#include "stage_timer.h"
+#include "volume.h"
+
+// 不依赖 R 的核心库
+// 肺分割（标记、clear_border、区域统计与肺区域筛选）、组织块生成、HU 比值检测与 NPDS、梯形积分以及
+// 基于参考样本的假设检验都在这里，全部基于调用者提供的缓冲区（指针加维度），不分配、不复制输入数据
+// src/ 中的 Rcpp 导出函数只把 R 对象转换为这些缓冲区（TypedVolume 直接指向 R 对象的数据）后调用这里的函数
+//
+// 在 R 之外使用：包含本头文件并与 npds_core.cpp 一起编译，只需要 C++11 标准库，OpenMP 可选，例如
+//   g++ -std=c++11 -O2 -fopenmp -I NPDS4Clib/src service.cpp NPDS4Clib/src/npds_core.cpp
+// 参数错误时抛出 std::invalid_argument（见 npds_error.h）
+// 线程：nthreads 为每次调用内部的 OpenMP 线程数；多个原生线程可以同时调用，每个线程使用自己的
+// NPDSWorkspace / LungSliceWork，同一个工作区同一时间只能被一个调用使用
+//
+// 一次检验的流程与 R 中相同：
+//   segment_lungs（两期子区域）-> score（NPDS）-> hypothesis_test（按结节大小组的参考样本）
+namespace npds {
+
+typedef TypedVolume Volume;
+
+// 由调用者的缓冲区描述体数据；维度为逻辑维度 [z, y, x]，xyz 为 true 时数据按 NIfTI 原始顺序（x 变化最快）存放
+Volume volume(const double *data, int n_slices, int nrow, int ncol, bool xyz = false);
+Volume volume(const int16_t *data, int n_slices, int nrow, int ncol, bool xyz = false);
+Volume volume(const float *data, int n_slices, int nrow, int ncol, bool xyz = false);
+Volume volume(const uint8_t *data, int n_slices, int nrow, int ncol, bool xyz = false);
+
+// 肺分割的参数，默认值与 get_segmented_lungs 相同
+struct SegmentOptions {
+  double threshold;   // 低于阈值的像素为前景
+  int buffer_size;    // 距图像边界 buffer_size + 1 个像素以内的区域视为接触边界
+  int connectivity;   // 4 或 8
+  int top_k;          // 保留面积最大的 top_k 个区域，< 0 时全部保留
+  int min_area;       // 面积下限
+  int max_extent;     // 边界框边长上限，<= 0 时按图像大小换算为 350 / 512
+  bool drop_border;   // 是否丢弃接触图像边界的区域（肺分割中即清除边界）
+
+  SegmentOptions()
+    : threshold(-400), buffer_size(0), connectivity(4), top_k(2), min_area(0), max_extent(-1),
+      drop_border(true) {}
+};
+
+// NPDS 计算的选项
+struct ScoreOptions {
+  int nthreads;               // OpenMP 线程数，结果与线程数无关
+  NPDSWorkspace *workspace;   // 复用的工作区，NULL 时使用临时工作区
+  const Volume *bf_mask;      // 两期肺掩膜（维度、布局与子区域相同），都给出时为稀疏评估
+  const Volume *af_mask;
+  double min_coverage;        // 稀疏评估中组织块在两期掩膜中的肺像素比例下限
+  StageTimes *times;          // 不为 NULL 时记录每一步的墙钟时间与 CPU 时间
+
+  ScoreOptions()
+    : nthreads(1), workspace(NULL), bf_mask(NULL), af_mask(NULL), min_coverage(0.0), times(NULL) {}
+};
+
+// 假设检验的结果
+struct TestResult {
+  int group;          // 结节大小组 1 到 4，直径为 NaN 时为 0
+  int progression;    // 1 / 0，NPDS 或直径为 NaN 时为 -1
+  double p_value;     // 参考样本中大于 NPDS 的比例，无法计算时为 NaN
+};
+
+// ---- 肺分割 ----
+
+// 连通区域标记，返回区域数；x 为 nrow x ncol 的列优先矩阵，非零为前景
+int bwlabel(const double *x, int nrow, int ncol, int *labels, int connectivity = 4);
+
+// 所有标签的面积、边界框、质心与是否接触边界；props[l] 对应标签 l；标签超过 num_labels 时返回 false
+bool regionprops(const int *labels, int num_labels, int nrow, int ncol, int buffer_size,
+                 std::vector<RegionProps> &props);
+
+// 按 options 的 top_k、min_area、max_extent 筛选肺区域：keep[l] 为是否保留标签 l，valid_regions 为保留的标签
+int select_lung_regions(const std::vector<RegionProps> &props, int nrow, int ncol, const SegmentOptions &options,
+                        std::vector<char> &keep, std::vector<int> &valid_regions);
+
+// 清除与图像边界相连的区域（包括接触边界的背景），原地把这些像素设为 bgval
+void clear_border(double *x, int nrow, int ncol, int buffer_size, double bgval, int connectivity,
+                  LungSliceWork &work);
+
+// 一张切片的肺分割：out 为肺内保留原值、肺外为 0 的图像，binary 为肺掩膜；返回保留的区域数
+int segment_lung_slice(const double *im, int nrow, int ncol, double *out, int *binary,
+                       const SegmentOptions &options, LungSliceWork &work);
+
+// n_volumes 个体数据所有切片的肺分割，按切片并行
+// out[k] 与 in[k] 同类型、同布局；binary[k] 为 mask_storage(in[k].type) 类型（double 输入为 int，其余为 uint8_t）
+void segment_lungs(const Volume *in, void *const *out, void *const *binary, int n_volumes,
+                   const SegmentOptions &options, int nthreads = 1, NPDSWorkspace *workspace = NULL);
+
+// ---- 组织块与 NPDS ----
+
+// 把切片的每个组织块展平：第 b 个组织块的第 p 个像素写入 result[b + block_num * p]
+void lung_tissue_blocks(const double *slice, int nrow, int ncol, int image_size, int split_size, double *result);
+
+// 默认的检测阈值 1 / 100, 2 / 100, ..., 1
+std::vector<double> detection_lambda();
+
+// 结节中心为 (x, y)（从 1 开始的像素坐标）时两期子区域的 NPDS
+// 每张切片的 NPDSt 写入 npdst[M]；稀疏评估时每张切片参与的组织块数写入 block_num[M]（可以为 NULL）
+double score(const Volume &bf, const Volume &af, double x, double y, int split_size, int image_size,
+             const double *detection_lambda, int R, double *npdst, int *block_num = NULL,
+             const ScoreOptions &options = ScoreOptions());
+
+// 梯形积分
+double trapz(const double *x, const double *y, int n);
+
+// ---- 假设检验 ----
+
+// 读取 CSV 文件中名为 column 的一列数值并升序排序（参考样本 ClinvSample_NPDS_G{1..4}.csv 的 S 列）
+std::vector<double> read_sorted_column(const std::string &path, const std::string &column);
+
+// 升序排列的 sorted[n] 中大于 x 的比例；x 为 NaN 或 n 为 0 时为 NaN
+double exceedance(const double *sorted, std::ptrdiff_t n, double x);
+
+// 结节大小组：<= 5 mm 为 1，<= 10 mm 为 2，<= 15 mm 为 3，其余为 4；NaN 为 0
+int clinv_group(double diameter_mm);
+
+// 与 hypothesis_test_by_ClinvNod_sample 相同的检验；reference[g - 1] 为第 g 组升序排列的参考样本，
+// 长度为 reference_size[g - 1]（R 中直接指向参考样本向量的数据）
+TestResult hypothesis_test(double npds, double diameter_mm, const double percentiles[4],
+                           const double *const reference[4], const std::ptrdiff_t reference_size[4]);
+TestResult hypothesis_test(double npds, double diameter_mm, const double percentiles[4],
+                           const std::vector<double> reference[4]);
+
+}  // namespace npds
+
+#endif
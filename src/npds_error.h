@@ -0,0 +1,13 @@
+#ifndef NPDS4CLIB_NPDS_ERROR_H
+#define NPDS4CLIB_NPDS_ERROR_H
+
+#include <stdexcept>
+#include <string>
+
+// 不依赖 R 的核函数报告参数错误时抛出 std::invalid_argument
+// 在 R 绑定中，Rcpp 生成的入口把异常转换为 R 的错误，消息与 Rcpp::stop 相同
+inline void npds_stop(const std::string &message) {
+  throw std::invalid_argument(message);
+}
+
+#endif
@@ -0,0 +1,166 @@
+#include <Rcpp.h>
+#include <cmath>
+#include <vector>
+#include "hu_ratio_fft.h"
+#include "npds.h"
+#include "typed_volume.h"
+#include "volume_utils.h"
+using namespace Rcpp;
+
+// 按存储类型逐切片计算候选中心窗口内每个平移的 NPDSt
+struct HeatmapTask {
+  VolumeLayout layout;
+  int split_size, split_num, radius;
+  const double *w[2];
+  int x_start, y_start;  // 窗口左上角，即平移 (-radius, -radius) 时结节块的左上角
+  const double *detection_lambda;
+  int R;
+  double *npdst;  // npdst[m + n_slices * (dy * n + dx)]
+  int nthreads;
+  NPDSWorkspace *ws;
+
+  template <class T>
+  void operator()(const T *bf, const T *af) {
+    int n_slices = layout.n_slices;
+    int block_num = split_num * split_num;
+    int n_pixels = split_size * split_size;
+    int n = 2 * radius + 1;
+    int window = split_size + 2 * radius;
+    std::ptrdiff_t slice_size = static_cast<std::ptrdiff_t>(block_num) * n_pixels;
+    const T *volume[2] = {bf, af};
+    FFTPlan plan = _fft_plan(_fft_size(window));
+    int P = plan.n;
+
+#ifdef _OPENMP
+#pragma omp parallel num_threads(nthreads)
+#endif
+    {
+      // 每个线程一份窗口频谱、比值之和与检测工作区，取自工作区
+      NPDSThreadWork &thread = ws->threads[_thread_id()];
+      HURatioFFTWork &work = thread.fft;
+      std::vector<fft_complex> &spectrum = thread.spectrum;
+      std::vector<double> *sums = thread.sums;
+      std::vector<double> &change = thread.change, &detection_list = thread.detection_list;
+      std::vector<double> &pos = thread.pos, &neg = thread.neg;
+      work.resize(P, n);
+      spectrum.resize(static_cast<std::size_t>(P) * P);
+      sums[0].resize(static_cast<std::size_t>(block_num) * n * n);
+      sums[1].resize(static_cast<std::size_t>(block_num) * n * n);
+      change.resize(block_num);
+      detection_list.resize(R);
+
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+      for (int m = 0; m < n_slices; m++) {
+        for (int s = 0; s < 2; s++) {
+          _hu_ratio_window_spectrum(volume[s], layout, m, y_start, x_start, window, plan,
+                                    spectrum.data(), work.line.data());
+          _hu_ratio_correlate_blocks(spectrum.data(), w[s] + m * slice_size, block_num, split_size, radius,
+                                     plan, sums[s].data(), work);
+        }
+
+        for (int o = 0; o < n * n; o++) {
+          const double *sum_1 = sums[0].data() + static_cast<std::ptrdiff_t>(block_num) * o;
+          const double *sum_2 = sums[1].data() + static_cast<std::ptrdiff_t>(block_num) * o;
+          for (int b = 0; b < block_num; b++) {
+            double mean_ratio_1 = sum_1[b] / n_pixels;
+            double mean_ratio_2 = sum_2[b] / n_pixels;
+            change[b] = (mean_ratio_2 - mean_ratio_1) / std::fabs(mean_ratio_1);
+          }
+          _hu_ratio_detection_sorted(change.data(), block_num, detection_lambda, R,
+                                     detection_list.data(), 1, pos, neg);
+          npdst[m + static_cast<std::ptrdiff_t>(n_slices) * o] = _trapz(detection_lambda, detection_list.data(), R);
+        }
+      }
+    }
+  }
+};
+
+// 以 voxel_coord 为中心、x、y 方向各平移 -radius 到 radius 个像素的所有候选结节中心的 NPDS
+// 每张切片上所有平移、所有组织块的比值之和由窗口与缓存的倒数矩阵（hu_ratio_reciprocal_cpp 的结果）的
+// FFT 互相关一次得到，不再为每个平移重新计算一次 NPDS（见 hu_ratio_fft.h）
+// 返回 (2 * radius + 1) x (2 * radius + 1) 的 NPDS 矩阵，第 dy + radius + 1 行、第 dx + radius + 1 列
+// 对应中心 (x + dx, y + dy)；以及维度为 c(M, 2 * radius + 1, 2 * radius + 1) 的 NPDSt
+// 结果与在各个中心上调用 npds_calculate_cpp 只在舍入误差内一致
+// workspace 为 npds_workspace() 创建的工作区时，每个线程的频谱与 FFT 工作区取自其中
+// [[Rcpp::export]]
+List npds_heatmap_cpp(SEXP bf_sub_image,
+                      SEXP af_sub_image,
+                      NumericVector bf_reciprocal,
+                      NumericVector af_reciprocal,
+                      NumericVector voxel_coord,
+                      int radius,
+                      int split_size,
+                      int image_size,
+                      NumericVector detection_lambda,
+                      int nthreads = 1,
+                      SEXP workspace = R_NilValue) {
+  const char *caller = "npds_heatmap_cpp";
+  if (voxel_coord.size() < 2) {
+    stop("npds_heatmap_cpp: voxel_coord must contain at least x and y.");
+  }
+  if (radius < 0) {
+    stop("npds_heatmap_cpp: radius must be non-negative.");
+  }
+  if (detection_lambda.size() == 0) {
+    stop("npds_heatmap_cpp: detection_lambda must not be empty.");
+  }
+
+  TypedVolume bf = typed_volume(bf_sub_image, caller);
+  TypedVolume af = typed_volume(af_sub_image, caller);
+  int bf_dims[3] = {bf.n_slices, bf.nrow, bf.ncol};
+  int af_dims[3] = {af.n_slices, af.nrow, af.ncol};
+  int M = bf.n_slices;
+  if (M == 0) {
+    stop("npds_heatmap_cpp: bf_sub_image has no slices.");
+  }
+
+  // 中心处结节块的左上角（0 起始下标），与 npds_calculate_cpp 中相同；窗口四角的结节块都必须在子区域内
+  int x_start = static_cast<int>(std::floor(voxel_coord[0] - split_size / 2.0)) - 1;
+  int y_start = static_cast<int>(std::floor(voxel_coord[1] - split_size / 2.0)) - 1;
+  check_block_geometry(bf_dims, af_dims, x_start - radius, y_start - radius, split_size, image_size, caller);
+  int split_num = check_block_geometry(bf_dims, af_dims, x_start + radius, y_start + radius,
+                                       split_size, image_size, caller);
+
+  int block_num = split_num * split_num;
+  R_xlen_t w_size = static_cast<R_xlen_t>(block_num) * split_size * split_size * M;
+  if (bf_reciprocal.size() != w_size || af_reciprocal.size() != w_size) {
+    stop("npds_heatmap_cpp: bf_reciprocal and af_reciprocal do not match the sub-images; "
+         "recompute them with hu_ratio_reciprocal_cpp.");
+  }
+
+  if (nthreads < 1) nthreads = 1;
+#ifndef _OPENMP
+  nthreads = 1;
+#endif
+
+  NPDSWorkspace local;
+  NPDSWorkspace *ws = workspace_arg(workspace, local, nthreads, caller);
+
+  int n = 2 * radius + 1;
+  NumericVector NPDSt(static_cast<R_xlen_t>(M) * n * n);
+  NPDSt.attr("dim") = IntegerVector::create(M, n, n);
+  NumericMatrix NPDS(n, n);
+
+  // npdst 中平移的下标为 dy * n + dx，NPDSt 的维度 c(M, dy, dx) 要求 dx * n + dy，计算后再换位
+  std::vector<double> npdst(static_cast<std::size_t>(M) * n * n);
+  HeatmapTask task = {volume_layout(bf), split_size, split_num, radius,
+                      {REAL(bf_reciprocal), REAL(af_reciprocal)},
+                      x_start - radius, y_start - radius,
+                      REAL(detection_lambda), static_cast<int>(detection_lambda.size()),
+                      npdst.data(), nthreads, ws};
+  dispatch_storage_pair(bf, af, task, caller);
+
+  for (int dy = 0; dy < n; dy++) {
+    for (int dx = 0; dx < n; dx++) {
+      const double *src = npdst.data() + static_cast<std::ptrdiff_t>(M) * (dy * n + dx);
+      double *dst = REAL(NPDSt) + static_cast<std::ptrdiff_t>(M) * (dx * n + dy);
+      for (int m = 0; m < M; m++) dst[m] = src[m];
+      NPDS(dy, dx) = _npds_select(src, M);
+    }
+  }
+
+  return List::create(Named("NPDS") = NPDS,
+                      Named("NPDSt") = NPDSt);
+}
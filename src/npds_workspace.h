@@ -0,0 +1,107 @@
+#ifndef NPDS4CLIB_NPDS_WORKSPACE_H
+#define NPDS4CLIB_NPDS_WORKSPACE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "hu_ratio_fft.h"
+#include "segment_lung_slice.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// 可复用的工作区：各核函数的临时缓冲区都从这里取得，不再在每次调用、每张切片上重新分配
+// 缓冲区用 resize / assign 调整大小，std::vector 变小时保留容量，只有需要的大小超过已有容量时才重新分配，
+// 因此同一个工作区在不超过创建时的 image_size / split_size 下反复使用时不再分配内存
+// R 中由 npds_workspace() 创建（外部指针）；没有传入工作区时核函数使用一个临时工作区，计算过程相同
+
+// 一个线程的工作区
+struct NPDSThreadWork {
+  std::vector<double> change;          // 一张切片所有组织块的变化率
+  std::vector<double> acc;             // 两期比值的累加
+  std::vector<double> detection_list;  // 检测列表
+  std::vector<double> pos, neg;        // 排序检测的工作区
+  std::vector<double> nodules;         // 一批结节的结节矩阵
+  std::vector<double> sums[2];         // 两期的比值之和
+  std::vector<fft_complex> spectrum;   // 窗口频谱
+  HURatioFFTWork fft;
+  LungSliceWork lung;                  // 切片肺分割与 clear_border
+};
+
+struct NPDSWorkspace {
+  int image_size, split_size;
+  std::vector<double> change;          // 整个子区域的变化率 change[m * block_num + b]
+  std::vector<int> volume_labels[2];   // 三维肺分割中两期的标记
+  std::vector<uint8_t> active;         // 稀疏评估中参与计算的组织块 active[m * block_num + b]
+  std::vector<NPDSThreadWork> threads;
+  double uses;                         // 被核函数使用的次数
+
+  NPDSWorkspace() : image_size(0), split_size(0), uses(0) {}
+
+  // 保证至少有 nthreads 个线程工作区；线程工作区在并行区之外增加
+  void reserve_threads(int nthreads) {
+    if (nthreads < 1) nthreads = 1;
+    if (static_cast<int>(threads.size()) < nthreads) threads.resize(nthreads);
+  }
+
+  // 按 image_size x image_size 的切片、split_size 的组织块为 nthreads 个线程预留缓冲区，
+  // radius 为 npds_heatmap_cpp 的平移半径（< 0 时不预留频谱），n_slices 为子区域的切片数
+  void reserve(int image_size_, int split_size_, int nthreads, int n_slices, int radius, int R) {
+    image_size = image_size_;
+    split_size = split_size_;
+    reserve_threads(nthreads);
+    int split_num = split_size > 0 ? image_size / split_size : 0;
+    std::size_t block_num = static_cast<std::size_t>(split_num) * split_num;
+    std::size_t image_pixels = static_cast<std::size_t>(image_size) * image_size;
+    change.reserve(block_num * (n_slices > 0 ? n_slices : 0));
+    for (std::size_t t = 0; t < threads.size(); t++) {
+      NPDSThreadWork &w = threads[t];
+      w.change.reserve(block_num);
+      w.acc.reserve(2 * block_num);
+      w.detection_list.reserve(R);
+      w.pos.reserve(block_num);
+      w.neg.reserve(block_num);
+      w.lung.labels.reserve(image_pixels);
+      w.lung.fg.bits.reserve(image_pixels / 64 + image_size);
+      w.lung.border.bits.reserve(image_pixels / 64 + image_size);
+      if (radius >= 0) {
+        int n = 2 * radius + 1;
+        int P = _fft_size(split_size + 2 * radius);
+        w.spectrum.reserve(static_cast<std::size_t>(P) * P);
+        w.fft.resize(P, n);
+        w.sums[0].reserve(block_num * n * n);
+        w.sums[1].reserve(block_num * n * n);
+      }
+    }
+  }
+
+  // 已预留的字节数
+  std::size_t bytes() const {
+    std::size_t total = change.capacity() * sizeof(double) + active.capacity() +
+                        (volume_labels[0].capacity() + volume_labels[1].capacity()) * sizeof(int);
+    for (std::size_t t = 0; t < threads.size(); t++) {
+      const NPDSThreadWork &w = threads[t];
+      total += (w.change.capacity() + w.acc.capacity() + w.detection_list.capacity() + w.pos.capacity() +
+                w.neg.capacity() + w.nodules.capacity() + w.sums[0].capacity() + w.sums[1].capacity()) *
+               sizeof(double);
+      total += (w.spectrum.capacity() + w.fft.kernel.capacity() + w.fft.line.capacity() +
+                w.fft.partial.capacity()) * sizeof(fft_complex);
+      total += (w.lung.labels.capacity() + w.lung.bwlabel.parent.capacity() +
+                w.lung.bwlabel.final_label.capacity() + w.lung.valid_regions.capacity()) * sizeof(int);
+      total += w.lung.props.capacity() * sizeof(RegionProps) + w.lung.keep.capacity();
+      total += (w.lung.fg.bits.capacity() + w.lung.border.bits.capacity()) * sizeof(uint64_t);
+    }
+    return total;
+  }
+};
+
+// 当前线程在并行区中的编号
+inline int _thread_id() {
+#ifdef _OPENMP
+  return omp_get_thread_num();
+#else
+  return 0;
+#endif
+}
+
+#endif
@@ -0,0 +1,25 @@
+#include <Rcpp.h>
+#include "npds_workspace.h"
+using namespace Rcpp;
+
+// 创建可在多次核函数调用之间复用的工作区，返回类为 npds_workspace 的外部指针，被回收时释放
+// 按 image_size x image_size 的子区域、split_size 的组织块为 nthreads 个线程预留缓冲区；
+// n_slices 为子区域的切片数，radius 为 npds_heatmap_cpp 的平移半径（< 0 时不预留），R 为阈值个数
+// 大小不够时各缓冲区在使用时自动扩大，预留只是避免第一次调用时的分配
+// [[Rcpp::export]]
+SEXP npds_workspace_cpp(int image_size, int split_size, int nthreads = 1, int n_slices = 0,
+                        int radius = -1, int R = 100) {
+  if (image_size < 0 || split_size <= 0) {
+    stop("npds_workspace_cpp: image_size must be non-negative and split_size positive.");
+  }
+
+  if (nthreads < 1) nthreads = 1;
+#ifndef _OPENMP
+  nthreads = 1;
+#endif
+
+  XPtr<NPDSWorkspace> ws(new NPDSWorkspace(), true);
+  ws->reserve(image_size, split_size, nthreads, n_slices, radius, R);
+  ws.attr("class") = "npds_workspace";
+  return ws;
+}
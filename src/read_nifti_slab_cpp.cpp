@@ -0,0 +1,279 @@
+#include <Rcpp.h>
+#include <zlib.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+#include "typed_volume.h"
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+using namespace Rcpp;
+
+// 只读取 NIfTI-1 文件头和指定范围的 k（第三维）切片
+// 磁盘上 x 变化最快，第 k 张切片是一段连续的 nx * ny 个体素，因此切片范围对应文件中连续的一段字节：
+//   未压缩的 .nii 用 mmap 只映射这一段（Windows 上用 fseek + fread）
+//   .nii.gz 用 zlib 顺序解压，gz_skip 跳过范围之前的数据，读到范围末尾即停止
+// 读出的切片默认直接写成 [z, y, x] 布局（z 变化最快），
+// 与 aperm(readNIfTI(path)@.Data, c(3, 2, 1))[(z_first + 1):(z_last + 1), , ] 相同，不需要整个体数据的 aperm；
+// layout 为 "xyz" 时保持文件中的顺序，结果带 npds_layout 属性，核函数按步长读取
+
+struct NiftiHeader {
+  int dim[8];
+  int datatype;
+  int bitpix;
+  double pixdim[8];
+  double vox_offset;
+  double scl_slope, scl_inter;
+  bool swapped;
+};
+
+static void swap_bytes(void *p, int size) {
+  unsigned char *b = static_cast<unsigned char *>(p);
+  for (int i = 0; i < size / 2; i++) std::swap(b[i], b[size - 1 - i]);
+}
+
+template <class T>
+static T header_field(const unsigned char *hdr, int offset, bool swapped) {
+  T v;
+  std::memcpy(&v, hdr + offset, sizeof(T));
+  if (swapped) swap_bytes(&v, sizeof(T));
+  return v;
+}
+
+// 解析 348 字节的 NIfTI-1 文件头
+static NiftiHeader parse_nifti_header(const unsigned char *hdr, const std::string &path) {
+  NiftiHeader h;
+  int sizeof_hdr = header_field<int32_t>(hdr, 0, false);
+  h.swapped = sizeof_hdr != 348;
+  if (h.swapped && header_field<int32_t>(hdr, 0, true) != 348) {
+    stop("read_nifti_slab_cpp: " + path + " is not a NIfTI-1 file.");
+  }
+  if (std::memcmp(hdr + 344, "n+1", 4) != 0) {
+    stop("read_nifti_slab_cpp: only single-file NIfTI-1 images (.nii, .nii.gz) are supported.");
+  }
+  for (int i = 0; i < 8; i++) {
+    h.dim[i] = header_field<int16_t>(hdr, 40 + 2 * i, h.swapped);
+    h.pixdim[i] = header_field<float>(hdr, 76 + 4 * i, h.swapped);
+  }
+  h.datatype = header_field<int16_t>(hdr, 70, h.swapped);
+  h.bitpix = header_field<int16_t>(hdr, 72, h.swapped);
+  h.vox_offset = header_field<float>(hdr, 108, h.swapped);
+  h.scl_slope = header_field<float>(hdr, 112, h.swapped);
+  h.scl_inter = header_field<float>(hdr, 116, h.swapped);
+  if (h.dim[0] < 3) {
+    stop("read_nifti_slab_cpp: " + path + " is not a 3D image.");
+  }
+  return h;
+}
+
+// 一个体素按 datatype 转换为 double
+static double nifti_value(const unsigned char *p, int datatype, bool swapped) {
+  switch (datatype) {
+  case 2: return *p;                                             // uint8
+  case 256: return static_cast<int8_t>(*p);                      // int8
+  case 4: return header_field<int16_t>(p, 0, swapped);           // int16
+  case 512: return header_field<uint16_t>(p, 0, swapped);        // uint16
+  case 8: return header_field<int32_t>(p, 0, swapped);           // int32
+  case 768: return header_field<uint32_t>(p, 0, swapped);        // uint32
+  case 16: return header_field<float>(p, 0, swapped);            // float32
+  case 64: return header_field<double>(p, 0, swapped);           // float64
+  }
+  return 0.0;
+}
+
+static int nifti_bytes(int datatype) {
+  switch (datatype) {
+  case 2: case 256: return 1;
+  case 4: case 512: return 2;
+  case 8: case 768: case 16: return 4;
+  case 64: return 8;
+  }
+  return 0;
+}
+
+// 把一张 k 切片（磁盘顺序，x 最快）写入输出的第 z 张切片；xyz 为 false 时输出为 [z, y, x] 布局
+// 与 oro.nifti 一致，scl_slope 非 0 时按 scl_slope * x + scl_inter 换算
+template <class T>
+static void write_plane(const unsigned char *plane, const NiftiHeader &h, int n_out, int z, bool xyz, T *out) {
+  int nx = h.dim[1], ny = h.dim[2];
+  int bytes = nifti_bytes(h.datatype);
+  bool rescale = h.scl_slope != 0;
+  VolumeLayout layout = xyz ? xyz_layout(n_out, ny, nx) : zyx_layout(n_out, ny, nx);
+  T *slice = out + z * layout.slice_stride;
+  for (int j = 0; j < ny; j++) {
+    for (int i = 0; i < nx; i++) {
+      double v = nifti_value(plane + (static_cast<std::ptrdiff_t>(j) * nx + i) * bytes, h.datatype, h.swapped);
+      if (rescale) v = h.scl_slope * v + h.scl_inter;
+      store_value(v, slice[j * layout.row_stride + i * layout.col_stride]);
+    }
+  }
+}
+
+static void write_plane(const unsigned char *plane, const NiftiHeader &h, int n_out, int z, bool xyz,
+                        StorageType type, void *out) {
+  switch (type) {
+  case STORAGE_INT16: write_plane(plane, h, n_out, z, xyz, static_cast<int16_t *>(out)); break;
+  case STORAGE_FLOAT32: write_plane(plane, h, n_out, z, xyz, static_cast<float *>(out)); break;
+  default: write_plane(plane, h, n_out, z, xyz, static_cast<double *>(out)); break;
+  }
+}
+
+// 打开的 .nii 或 .nii.gz 文件，离开作用域时关闭
+struct NiftiFile {
+  gzFile gz;
+  std::FILE *file;
+
+  NiftiFile() : gz(NULL), file(NULL) {}
+  ~NiftiFile() {
+    if (gz != NULL) gzclose(gz);
+    if (file != NULL) std::fclose(file);
+  }
+};
+
+static bool is_gzip(const std::string &path) {
+  return path.size() > 3 && path.compare(path.size() - 3, 3, ".gz") == 0;
+}
+
+// 打开文件并读取文件头；.gz 结尾的文件按 gzip 压缩处理
+static NiftiHeader open_nifti(const std::string &path, NiftiFile &f) {
+  unsigned char hdr[348];
+  if (is_gzip(path)) {
+    f.gz = gzopen(path.c_str(), "rb");
+    if (f.gz == NULL || gzread(f.gz, hdr, 348) != 348) {
+      stop("read_nifti_slab_cpp: cannot read " + path + ".");
+    }
+  } else {
+    f.file = std::fopen(path.c_str(), "rb");
+    if (f.file == NULL || std::fread(hdr, 1, 348, f.file) != 348) {
+      stop("read_nifti_slab_cpp: cannot read " + path + ".");
+    }
+  }
+  return parse_nifti_header(hdr, path);
+}
+
+// 只读取文件头，返回 dim（nx, ny, nz）和 pixdim
+// [[Rcpp::export]]
+List read_nifti_header_cpp(std::string path) {
+  NiftiFile f;
+  NiftiHeader h = open_nifti(path, f);
+  return List::create(Named("dim") = IntegerVector::create(h.dim[1], h.dim[2], h.dim[3]),
+                      Named("pixdim") = NumericVector(h.pixdim, h.pixdim + 8));
+}
+
+// 把解压后数据流的读取位置向前移到 offset（从数据流开头算起，文件头已经读过）
+// 有 64 位偏移的 gzseek64 时直接使用；否则 z_off_t 可能只有 32 位（例如 Windows 上的 long），
+// 超过 2 GB 的偏移会溢出，因此不转换偏移，而是分块解压并丢弃（gzseek 向前跳过时同样需要解压这些数据）
+static bool gz_skip(gzFile gz, long long offset) {
+#if defined(_LARGEFILE64_SOURCE) && _LFS64_LARGEFILE-0
+  return gzseek64(gz, static_cast<z_off64_t>(offset), SEEK_SET) == static_cast<z_off64_t>(offset);
+#else
+  // 当前位置只是文件头的长度，不会溢出
+  long long position = static_cast<long long>(gztell(gz));
+  if (position < 0 || position > offset) return false;
+  offset -= position;
+  std::vector<unsigned char> chunk(1 << 16);
+  while (offset > 0) {
+    unsigned n = static_cast<unsigned>(offset < static_cast<long long>(chunk.size()) ? offset : chunk.size());
+    if (gzread(gz, chunk.data(), n) != static_cast<int>(n)) return false;
+    offset -= n;
+  }
+  return true;
+#endif
+}
+
+// 读取 NIfTI 文件中第 z_first 到第 z_last 张 k 切片（从 0 开始，包含两端）
+// 返回 image（[z, y, x] 或 layout = "xyz" 时的文件顺序，存储类型为 storage）、dim（nx, ny, nz）和 pixdim
+// [[Rcpp::export]]
+List read_nifti_slab_cpp(std::string path, int z_first, int z_last, std::string storage = "double",
+                         std::string layout = "zyx") {
+  StorageType type = parse_storage(storage, "read_nifti_slab_cpp");
+  if (type == STORAGE_UINT8) {
+    stop("read_nifti_slab_cpp: storage must be \"double\", \"int16\" or \"float32\".");
+  }
+  if (layout != "zyx" && layout != "xyz") {
+    stop("read_nifti_slab_cpp: layout must be \"zyx\" or \"xyz\".");
+  }
+  bool xyz = layout == "xyz";
+  bool gz = is_gzip(path);
+
+  NiftiFile f;
+  NiftiHeader h = open_nifti(path, f);
+  int nx = h.dim[1], ny = h.dim[2], nz = h.dim[3];
+  int bytes = nifti_bytes(h.datatype);
+  if (bytes == 0 || bytes * 8 != h.bitpix) {
+    stop("read_nifti_slab_cpp: unsupported NIfTI datatype.");
+  }
+  if (z_first < 0 || z_last >= nz || z_first > z_last) {
+    stop("read_nifti_slab_cpp: slice range is out of bounds.");
+  }
+
+  int n_out = z_last - z_first + 1;
+  std::size_t plane_bytes = static_cast<std::size_t>(nx) * ny * bytes;
+  long long slab_offset = static_cast<long long>(h.vox_offset) + static_cast<long long>(z_first) * plane_bytes;
+  RObject image = new_typed_volume(type, xyz ? IntegerVector::create(nx, ny, n_out)
+                                             : IntegerVector::create(n_out, ny, nx));
+  if (xyz) {
+    SEXP tag = PROTECT(Rf_mkString("xyz"));
+    Rf_setAttrib(image, Rf_install("npds_layout"), tag);
+    UNPROTECT(1);
+  }
+  void *out = storage_data(image);
+
+  if (gz) {
+    // 解压并丢弃范围之前的数据，之后逐张切片解压，读到范围末尾即停止
+    std::vector<unsigned char> plane(plane_bytes);
+    if (!gz_skip(f.gz, slab_offset)) {
+      stop("read_nifti_slab_cpp: cannot seek in " + path + ".");
+    }
+    for (int z = 0; z < n_out; z++) {
+      if (gzread(f.gz, plane.data(), static_cast<unsigned>(plane_bytes)) != static_cast<int>(plane_bytes)) {
+        stop("read_nifti_slab_cpp: " + path + " is truncated.");
+      }
+      write_plane(plane.data(), h, n_out, z, xyz, type, out);
+    }
+  } else {
+#ifndef _WIN32
+    // 只映射切片范围所在的页
+    int fd = fileno(f.file);
+    struct stat st;
+    std::size_t slab_bytes = plane_bytes * n_out;
+    if (fstat(fd, &st) != 0 || static_cast<long long>(st.st_size) < slab_offset + static_cast<long long>(slab_bytes)) {
+      stop("read_nifti_slab_cpp: " + path + " is truncated.");
+    }
+    long page = sysconf(_SC_PAGESIZE);
+    off_t map_offset = static_cast<off_t>(slab_offset / page * page);
+    std::size_t map_bytes = slab_bytes + static_cast<std::size_t>(slab_offset - map_offset);
+    void *map = mmap(NULL, map_bytes, PROT_READ, MAP_PRIVATE, fd, map_offset);
+    if (map == MAP_FAILED) {
+      stop("read_nifti_slab_cpp: cannot map " + path + ".");
+    }
+    const unsigned char *slab = static_cast<const unsigned char *>(map) + (slab_offset - map_offset);
+    for (int z = 0; z < n_out; z++) {
+      write_plane(slab + z * plane_bytes, h, n_out, z, xyz, type, out);
+    }
+    munmap(map, map_bytes);
+#else
+    std::vector<unsigned char> plane(plane_bytes);
+    // Windows 上 long 为 32 位，超过 2 GB 的偏移用 _fseeki64
+    if (_fseeki64(f.file, static_cast<__int64>(slab_offset), SEEK_SET) != 0) {
+      stop("read_nifti_slab_cpp: cannot seek in " + path + ".");
+    }
+    for (int z = 0; z < n_out; z++) {
+      if (std::fread(plane.data(), 1, plane_bytes, f.file) != plane_bytes) {
+        stop("read_nifti_slab_cpp: " + path + " is truncated.");
+      }
+      write_plane(plane.data(), h, n_out, z, xyz, type, out);
+    }
+#endif
+  }
+
+  NumericVector pixdim(h.pixdim, h.pixdim + 8);
+  return List::create(Named("image") = image,
+                      Named("dim") = IntegerVector::create(nx, ny, nz),
+                      Named("pixdim") = pixdim);
+}
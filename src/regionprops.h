@@ -0,0 +1,86 @@
+#ifndef NPDS4CLIB_REGIONPROPS_H
+#define NPDS4CLIB_REGIONPROPS_H
+
+#include <vector>
+#include "bitmask.h"
+#include "bwlabel.h"
+
+// 单个连通区域的统计量，坐标均为从 0 开始的下标（x 为行，y 为列，与 regionprops_bbox 一致）
+struct RegionProps {
+  int area;
+  int x_min, x_max;
+  int y_min, y_max;
+  double sum_x, sum_y;  // 坐标累加，除以 area 即为质心
+  bool on_border;       // 是否有像素落在距图像边界 buffer_size + 1 以内
+};
+
+// 一次遍历标签图像，得到所有标签的面积、边界框、质心与边界接触标记
+// labels 为列优先存储，props 调整为 num_labels + 1 个元素，下标即标签（0 为背景，不统计）
+// 若出现大于 num_labels 的标签则返回 false
+inline bool _regionprops(const int *labels, int num_labels, XYPoint size, int buffer_size,
+                         std::vector<RegionProps> &props) {
+  int nrow = size.x;
+  int ncol = size.y;
+  int ext = buffer_size + 1;
+
+  RegionProps empty = {0, nrow, -1, ncol, -1, 0.0, 0.0, false};
+  props.assign(num_labels + 1, empty);
+
+  int pos = 0;
+  for (int j = 0; j < ncol; j++) {
+    bool col_border = (j < ext) || (j >= ncol - ext);
+    for (int i = 0; i < nrow; i++, pos++) {
+      int label = labels[pos];
+      if (label <= 0) continue;
+      if (label > num_labels) return false;
+
+      RegionProps &p = props[label];
+      p.area++;
+      if (i < p.x_min) p.x_min = i;
+      if (i > p.x_max) p.x_max = i;
+      if (j < p.y_min) p.y_min = j;
+      if (j > p.y_max) p.y_max = j;
+      p.sum_x += i;
+      p.sum_y += j;
+      if (col_border || i < ext || i >= nrow - ext) p.on_border = true;
+    }
+  }
+  return true;
+}
+
+// 同上，只遍历前景掩膜 fg 中置位的像素；labels 须为对 fg 标记的结果（背景为 0）
+inline bool _regionprops(const int *labels, const BitMask &fg, int num_labels, int buffer_size,
+                         std::vector<RegionProps> &props) {
+  int nrow = fg.nrow;
+  int ncol = fg.ncol;
+  int ext = buffer_size + 1;
+
+  RegionProps empty = {0, nrow, -1, ncol, -1, 0.0, 0.0, false};
+  props.assign(num_labels + 1, empty);
+
+  for (int j = 0; j < ncol; j++) {
+    bool col_border = (j < ext) || (j >= ncol - ext);
+    const uint64_t *col = fg.column(j);
+    const int *col_labels = labels + static_cast<std::ptrdiff_t>(j) * nrow;
+    for (int w = 0; w < fg.words; w++) {
+      for (uint64_t word = col[w]; word; word &= word - 1) {
+        int i = 64 * w + _bit_ctz(word);
+        int label = col_labels[i];
+        if (label > num_labels) return false;
+
+        RegionProps &p = props[label];
+        p.area++;
+        if (i < p.x_min) p.x_min = i;
+        if (i > p.x_max) p.x_max = i;
+        if (j < p.y_min) p.y_min = j;
+        if (j > p.y_max) p.y_max = j;
+        p.sum_x += i;
+        p.sum_y += j;
+        if (col_border || i < ext || i >= nrow - ext) p.on_border = true;
+      }
+    }
+  }
+  return true;
+}
+
+#endif
@@ -1,42 +1,38 @@
 #include <Rcpp.h>
+#include <vector>
+#include "npds_core.h"
 using namespace Rcpp;
 
-#include <Rcpp.h>
-using namespace Rcpp;
+// 对 bwlabel 的返回结果做一次遍历统计
+static std::vector<RegionProps> regionprops_from_input(List input, int buffer_size) {
+  IntegerMatrix labeled_image = input["labeled_image"];
+  int num_labels = input["num_labels"];
+
+  std::vector<RegionProps> props;
+  if (!npds::regionprops(INTEGER(labeled_image), num_labels, labeled_image.nrow(), labeled_image.ncol(),
+                         buffer_size, props)) {
+    stop("regionprops: Detected a label greater than num_labels.");
+  }
+  return props;
+}
 
 // [[Rcpp::export]]
 IntegerMatrix regionprops_bbox(List input) {
-  IntegerMatrix labeled_image = input["labeled_image"];
-  int num_labels = input["num_labels"];
+  std::vector<RegionProps> props = regionprops_from_input(input, 0);
+  int num_labels = static_cast<int>(props.size()) - 1;
 
   // 初始化一个二维矩阵来存储每个标签的边界框
   IntegerMatrix bboxes(num_labels, 4);
 
-  // 遍历每个标签（排除背景标签 0）
   for (int label = 1; label <= num_labels; label++) {
-    int x_min = labeled_image.nrow();
-    int x_max = -1;
-    int y_min = labeled_image.ncol();
-    int y_max = -1;
-
-    // 遍历图像的所有像素
-    for (int i = 0; i < labeled_image.nrow(); i++) {
-      for (int j = 0; j < labeled_image.ncol(); j++) {
-        if (labeled_image(i, j) == label) {
-          if (i < x_min) x_min = i;
-          if (i > x_max) x_max = i;
-          if (j < y_min) y_min = j;
-          if (j > y_max) y_max = j;
-        }
-      }
-    }
+    const RegionProps &p = props[label];
 
     // 将边界框信息存储到矩阵中
-    if (x_max != -1) {
-      bboxes(label - 1, 0) = x_min;
-      bboxes(label - 1, 1) = x_max;
-      bboxes(label - 1, 2) = y_min;
-      bboxes(label - 1, 3) = y_max;
+    if (p.area > 0) {
+      bboxes(label - 1, 0) = p.x_min;
+      bboxes(label - 1, 1) = p.x_max;
+      bboxes(label - 1, 2) = p.y_min;
+      bboxes(label - 1, 3) = p.y_max;
     } else {
       // 如果标签没有有效像素点，用 NA 表示
       bboxes(label - 1, 0) = NA_INTEGER;
@@ -49,3 +45,44 @@ IntegerMatrix regionprops_bbox(List input) {
   return bboxes;
 }
 
+// 一次遍历得到所有标签的面积、边界框、质心以及是否接触图像边界
+// 第 i 行对应标签 i；坐标为从 0 开始的下标，没有像素的标签其边界框与质心为 NA
+// [[Rcpp::export]]
+DataFrame regionprops_cpp(List input, int buffer_size = 0) {
+  std::vector<RegionProps> props = regionprops_from_input(input, buffer_size);
+  int num_labels = static_cast<int>(props.size()) - 1;
+
+  IntegerVector label(num_labels), area(num_labels);
+  IntegerVector x_min(num_labels), x_max(num_labels), y_min(num_labels), y_max(num_labels);
+  NumericVector centroid_x(num_labels), centroid_y(num_labels);
+  LogicalVector touches_border(num_labels);
+
+  for (int l = 1; l <= num_labels; l++) {
+    const RegionProps &p = props[l];
+    int i = l - 1;
+    label[i] = l;
+    area[i] = p.area;
+    touches_border[i] = p.on_border;
+    if (p.area > 0) {
+      x_min[i] = p.x_min;
+      x_max[i] = p.x_max;
+      y_min[i] = p.y_min;
+      y_max[i] = p.y_max;
+      centroid_x[i] = p.sum_x / p.area;
+      centroid_y[i] = p.sum_y / p.area;
+    } else {
+      x_min[i] = x_max[i] = y_min[i] = y_max[i] = NA_INTEGER;
+      centroid_x[i] = centroid_y[i] = NA_REAL;
+    }
+  }
+
+  return DataFrame::create(Named("label") = label,
+                           Named("area") = area,
+                           Named("x_min") = x_min,
+                           Named("x_max") = x_max,
+                           Named("y_min") = y_min,
+                           Named("y_max") = y_max,
+                           Named("centroid_x") = centroid_x,
+                           Named("centroid_y") = centroid_y,
+                           Named("touches_border") = touches_border);
+}
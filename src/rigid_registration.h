@@ -0,0 +1,205 @@
+#ifndef NPDS4CLIB_RIGID_REGISTRATION_H
+#define NPDS4CLIB_RIGID_REGISTRATION_H
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+#include "block_view.h"
+
+// 刚体配准的相似性度量与重采样
+// 体素坐标 v = (x, y, z)：体数据第 m 张切片 (i, j) 像素为 (j, i, m)
+// 世界坐标（毫米）由 NIfTI 的方向给出：p = D (s * v) + o
+//   s 为取绝对值的像素间距，D 为 3 x 3 的方向矩阵（含翻转），o 为第一个体素的位置
+//   orientation 为列优先的 3 x 4 矩阵 [D | o]，由 R 中的 nifti_orientation 按 sform / qform 得到
+// 刚体变换把随访（目标）体数据中的点 p 映射到基线（源）体数据中的点（都是世界坐标）
+//   q = R (p - c) + c + t，R = Rz(rz) Ry(ry) Rx(rx)
+// params = (rx, ry, rz, tx, ty, tz)，角度为弧度，平移为毫米；c 为旋转中心
+
+// 目标体素坐标到源体素坐标的仿射映射 v_s = a v_t + b（a 行优先存储），由刚体变换和两期的方向合成
+struct RigidTransform {
+  double a[9];
+  double b[3];
+};
+
+// 3 x 3 矩阵（行优先）的逆矩阵；奇异时返回 false
+inline bool _invert3(const double *m, double *inv) {
+  double c0 = m[4] * m[8] - m[5] * m[7];
+  double c1 = m[5] * m[6] - m[3] * m[8];
+  double c2 = m[3] * m[7] - m[4] * m[6];
+  double det = m[0] * c0 + m[1] * c1 + m[2] * c2;
+  if (!(std::fabs(det) > 1e-12)) return false;
+  inv[0] = c0 / det;
+  inv[1] = (m[2] * m[7] - m[1] * m[8]) / det;
+  inv[2] = (m[1] * m[5] - m[2] * m[4]) / det;
+  inv[3] = c1 / det;
+  inv[4] = (m[0] * m[8] - m[2] * m[6]) / det;
+  inv[5] = (m[2] * m[3] - m[0] * m[5]) / det;
+  inv[6] = c2 / det;
+  inv[7] = (m[1] * m[6] - m[0] * m[7]) / det;
+  inv[8] = (m[0] * m[4] - m[1] * m[3]) / det;
+  return true;
+}
+
+// 体素坐标到世界坐标的线性部分 D diag(s)（行优先），orientation 为列优先的 [D | o]
+inline void _voxel_to_world(const double *spacing, const double *orientation, double *m) {
+  for (int r = 0; r < 3; r++) {
+    for (int c = 0; c < 3; c++) m[3 * r + c] = orientation[r + 3 * c] * spacing[c];
+  }
+}
+
+// 由刚体参数、旋转中心和两期的方向合成目标体素到源体素的映射
+// v_s = A_s^-1 (R (A_t v_t + o_t - c) + c + t - o_s)；源体数据的方向矩阵奇异时返回 false
+inline bool _rigid_transform(const double *params, const double *center,
+                             const double *target_spacing, const double *target_orientation,
+                             const double *source_spacing, const double *source_orientation,
+                             RigidTransform &tr) {
+  double cx = std::cos(params[0]), sx = std::sin(params[0]);
+  double cy = std::cos(params[1]), sy = std::sin(params[1]);
+  double cz = std::cos(params[2]), sz = std::sin(params[2]);
+  // Rz * Ry * Rx
+  double r[9] = {cz * cy, cz * sy * sx - sz * cx, cz * sy * cx + sz * sx,
+                 sz * cy, sz * sy * sx + cz * cx, sz * sy * cx - cz * sx,
+                 -sy, cy * sx, cy * cx};
+
+  double at[9], as[9], as_inv[9];
+  _voxel_to_world(target_spacing, target_orientation, at);
+  _voxel_to_world(source_spacing, source_orientation, as);
+  if (!_invert3(as, as_inv)) return false;
+
+  // 世界坐标中的平移部分 R (o_t - c) + c + t - o_s
+  double w[3];
+  for (int k = 0; k < 3; k++) {
+    w[k] = center[k] + params[3 + k] - source_orientation[9 + k];
+    for (int l = 0; l < 3; l++) w[k] += r[3 * k + l] * (target_orientation[9 + l] - center[l]);
+  }
+  double ra[9];
+  for (int k = 0; k < 3; k++) {
+    for (int l = 0; l < 3; l++) {
+      ra[3 * k + l] = r[3 * k] * at[l] + r[3 * k + 1] * at[3 + l] + r[3 * k + 2] * at[6 + l];
+    }
+  }
+  for (int k = 0; k < 3; k++) {
+    tr.b[k] = as_inv[3 * k] * w[0] + as_inv[3 * k + 1] * w[1] + as_inv[3 * k + 2] * w[2];
+    for (int l = 0; l < 3; l++) {
+      tr.a[3 * k + l] = as_inv[3 * k] * ra[l] + as_inv[3 * k + 1] * ra[3 + l] + as_inv[3 * k + 2] * ra[6 + l];
+    }
+  }
+  return true;
+}
+
+// 目标体数据中体素 (j, i, m) 变换后在源体数据中的体素坐标 (x, y, z)
+inline void _rigid_apply(const RigidTransform &tr, double j, double i, double m, double *v) {
+  for (int a = 0; a < 3; a++) {
+    v[a] = tr.a[3 * a] * j + tr.a[3 * a + 1] * i + tr.a[3 * a + 2] * m + tr.b[a];
+  }
+}
+
+// 源体数据在体素坐标 (x, y, z) 处的三线性插值；超出范围时返回 false
+template <class T>
+inline bool _trilinear(const T *volume, const VolumeLayout &layout, const double *v, double &value) {
+  double x = v[0], y = v[1], z = v[2];
+  // 取反的区间判断同时排除 NaN；转换为 int 之前坐标必须已在源体数据之内
+  if (!(x >= 0 && y >= 0 && z >= 0 && x <= layout.ncol - 1 && y <= layout.nrow - 1 && z <= layout.n_slices - 1)) {
+    return false;
+  }
+  int j0 = static_cast<int>(x), i0 = static_cast<int>(y), m0 = static_cast<int>(z);
+  int j1 = j0 + 1 < layout.ncol ? j0 + 1 : j0;
+  int i1 = i0 + 1 < layout.nrow ? i0 + 1 : i0;
+  int m1 = m0 + 1 < layout.n_slices ? m0 + 1 : m0;
+  double fx = x - j0, fy = y - i0, fz = z - m0;
+
+  const T *s0 = volume + m0 * layout.slice_stride;
+  const T *s1 = volume + m1 * layout.slice_stride;
+  std::ptrdiff_t a0 = i0 * layout.row_stride, a1 = i1 * layout.row_stride;
+  std::ptrdiff_t b0 = j0 * layout.col_stride, b1 = j1 * layout.col_stride;
+  double c00 = s0[a0 + b0] * (1 - fx) + s0[a0 + b1] * fx;
+  double c01 = s0[a1 + b0] * (1 - fx) + s0[a1 + b1] * fx;
+  double c10 = s1[a0 + b0] * (1 - fx) + s1[a0 + b1] * fx;
+  double c11 = s1[a1 + b0] * (1 - fx) + s1[a1 + b1] * fx;
+  value = (c00 * (1 - fy) + c01 * fy) * (1 - fz) + (c10 * (1 - fy) + c11 * fy) * fz;
+  return true;
+}
+
+// 目标体数据第 z_first 到第 z_last 张切片（从 0 开始）上每隔 step 个体素取样，
+// 与变换后源体数据的三线性插值计算归一化互相关（NCC）
+// 落在源体数据之外的样本不计入；样本少于两个或方差为 0 时返回 0
+// 按切片并行计算部分和，再按切片顺序合并，结果与 nthreads 无关
+template <class T>
+inline double _rigid_ncc(const T *target, const VolumeLayout &target_layout,
+                         const T *source, const VolumeLayout &source_layout, const RigidTransform &tr, int z_first, int z_last, int step, int nthreads = 1) {
+  int n_planes = (z_last - z_first) / step + 1;
+  // 每个取样切片的 n, sum_t, sum_s, sum_tt, sum_ss, sum_ts
+  std::vector<double> partial(static_cast<std::size_t>(n_planes) * 6, 0.0);
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(nthreads) schedule(dynamic)
+#endif
+  for (int k = 0; k < n_planes; k++) {
+    int m = z_first + k * step;
+    double *acc = partial.data() + 6 * k;
+    const T *slice = target + m * target_layout.slice_stride;
+    double v[3], s;
+    for (int i = 0; i < target_layout.nrow; i += step) {
+      for (int j = 0; j < target_layout.ncol; j += step) {
+        _rigid_apply(tr, j, i, m, v);
+        if (!_trilinear(source, source_layout, v, s)) continue;
+        double t = static_cast<double>(slice[i * target_layout.row_stride + j * target_layout.col_stride]);
+        acc[0] += 1;
+        acc[1] += t;
+        acc[2] += s;
+        acc[3] += t * t;
+        acc[4] += s * s;
+        acc[5] += t * s;
+      }
+    }
+  }
+
+  double sum[6] = {0, 0, 0, 0, 0, 0};
+  for (int k = 0; k < n_planes; k++) {
+    for (int a = 0; a < 6; a++) sum[a] += partial[6 * k + a];
+  }
+  double n = sum[0];
+  if (n < 2) return 0.0;
+  double var_t = sum[3] - sum[1] * sum[1] / n;
+  double var_s = sum[4] - sum[2] * sum[2] / n;
+  double cov = sum[5] - sum[1] * sum[2] / n;
+  if (var_t <= 0 || var_s <= 0) return 0.0;
+  return cov / std::sqrt(var_t * var_s);
+}
+
+// 最近邻下标：v 为有限值且落在 [-0.5, n - 0.5) 内时 k = floor(v + 0.5) 并返回 true
+// 先比较 double 再转换，极端的旋转或平移（Nelder-Mead 可能尝试）得到的非有限或超出 int 范围的坐标不会被转换
+inline bool _nearest_index(double v, int n, int &k) {
+  if (!std::isfinite(v) || !(v >= -0.5 && v < n - 0.5)) return false;
+  k = static_cast<int>(std::floor(v + 0.5));
+  return true;
+}
+
+// 把源体数据按变换重采样到目标体数据网格的第 z_first 到第 z_last 张切片上
+// out 只包含这些切片：第 m 张切片写入 out 的第 m - z_first 张
+// 与 RNiftyReg 的 interpolation = 0 一致使用最近邻插值，落在源体数据之外的体素填 0
+template <class T>
+inline void _rigid_resample(const T *source, const VolumeLayout &source_layout, const VolumeLayout &out_layout,
+                            const RigidTransform &tr, int z_first, int z_last, T *out, int nthreads = 1) {
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(nthreads) schedule(dynamic)
+#endif
+  for (int m = z_first; m <= z_last; m++) {
+    T *slice = out + (m - z_first) * out_layout.slice_stride;
+    double v[3];
+    for (int i = 0; i < out_layout.nrow; i++) {
+      for (int j = 0; j < out_layout.ncol; j++) {
+        _rigid_apply(tr, j, i, m, v);
+        int sj, si, sm;
+        T value = T(0);
+        if (_nearest_index(v[0], source_layout.ncol, sj) && _nearest_index(v[1], source_layout.nrow, si) &&
+            _nearest_index(v[2], source_layout.n_slices, sm)) {
+          value = source[sm * source_layout.slice_stride + si * source_layout.row_stride + sj * source_layout.col_stride];
+        }
+        slice[i * out_layout.row_stride + j * out_layout.col_stride] = value;
+      }
+    }
+  }
+}
+
+#endif
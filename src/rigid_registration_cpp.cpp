@@ -0,0 +1,121 @@
+#include <Rcpp.h>
+#include "rigid_registration.h"
+#include "typed_volume.h"
+using namespace Rcpp;
+
+// 按存储类型计算 NCC
+struct RigidMetricTask {
+  VolumeLayout target_layout, source_layout;
+  RigidTransform tr;
+  int z_first, z_last, step, nthreads;
+  double ncc;
+
+  template <class T>
+  void operator()(const T *target, const T *source) {
+    ncc = _rigid_ncc(target, target_layout, source, source_layout, tr, z_first, z_last, step, nthreads);
+  }
+};
+
+// 按存储类型重采样
+struct RigidResampleTask {
+  VolumeLayout source_layout, out_layout;
+  RigidTransform tr;
+  int z_first, z_last;
+  void *out;
+  int nthreads;
+
+  template <class T>
+  void operator()(const T *target, const T *source) {
+    (void) target;
+    _rigid_resample(source, source_layout, out_layout, tr, z_first, z_last, static_cast<T *>(out), nthreads);
+  }
+};
+
+// 检查参数并合成目标体素到源体素的映射
+// spacing 为取绝对值后的像素间距，翻转与方向都在 orientation（列优先的 3 x 4 矩阵 [D | o]）中
+static RigidTransform rigid_arguments(NumericVector params, NumericVector center,
+                                      NumericVector target_spacing, NumericVector source_spacing,
+                                      NumericVector target_orientation, NumericVector source_orientation,
+                                      const char *caller) {
+  if (params.size() != 6 || center.size() != 3 || target_spacing.size() != 3 || source_spacing.size() != 3) {
+    stop(std::string(caller) + ": params must have length 6; center and the spacings must have length 3.");
+  }
+  if (target_orientation.size() != 12 || source_orientation.size() != 12) {
+    stop(std::string(caller) + ": the orientations must be 3 x 4 matrices.");
+  }
+  for (int a = 0; a < 3; a++) {
+    if (!(target_spacing[a] > 0) || !(source_spacing[a] > 0)) {
+      stop(std::string(caller) + ": voxel spacings must be positive; pass abs(pixdim) and the flips in the orientation.");
+    }
+  }
+  RigidTransform tr;
+  if (!_rigid_transform(REAL(params), REAL(center), REAL(target_spacing), REAL(target_orientation),
+                        REAL(source_spacing), REAL(source_orientation), tr)) {
+    stop(std::string(caller) + ": the baseline orientation is singular.");
+  }
+  return tr;
+}
+
+// 随访体数据 target 第 z_first 到第 z_last 张切片（从 0 开始）与刚体变换后的基线体数据 source 的 NCC
+// params = c(rx, ry, rz, tx, ty, tz)，center 为旋转中心（世界坐标，毫米）
+// spacing 为 (x, y, z) 方向像素间距的绝对值，orientation 为 nifti_orientation 得到的 3 x 4 矩阵
+// step 为取样间隔，用于多分辨率配准的粗层级；两期体数据的存储类型和布局必须相同
+// nthreads 为 OpenMP 线程数，结果与线程数无关
+// [[Rcpp::export]]
+double rigid_metric_cpp(SEXP target, SEXP source, NumericVector params, NumericVector center,
+                        NumericVector target_spacing, NumericVector source_spacing,
+                        NumericVector target_orientation, NumericVector source_orientation,
+                        int z_first, int z_last, int step = 1, int nthreads = 1) {
+  const char *caller = "rigid_metric_cpp";
+  RigidTransform tr = rigid_arguments(params, center, target_spacing, source_spacing,
+                                      target_orientation, source_orientation, caller);
+  TypedVolume t = typed_volume(target, caller);
+  TypedVolume s = typed_volume(source, caller);
+  require_image_storage(t, caller);
+  require_image_storage(s, caller);
+  if (z_first < 0 || z_last >= t.n_slices || z_first > z_last) {
+    stop("rigid_metric_cpp: slice range is out of bounds.");
+  }
+  if (step < 1) step = 1;
+  if (nthreads < 1) nthreads = 1;
+#ifndef _OPENMP
+  nthreads = 1;
+#endif
+
+  RigidMetricTask task = {volume_layout(t), volume_layout(s), tr, z_first, z_last, step, nthreads, 0.0};
+  dispatch_storage_pair(t, s, task, caller);
+  return task.ncc;
+}
+
+// 把基线体数据 source 按刚体变换重采样到随访体数据 target 网格的第 z_first 到第 z_last 张切片上
+// （最近邻插值，范围之外填 0），只计算这些切片
+// 结果为 z_last - z_first + 1 张切片，平面维度、布局与 target 相同，存储类型与 source 相同
+// [[Rcpp::export]]
+SEXP rigid_resample_cpp(SEXP target, SEXP source, NumericVector params, NumericVector center,
+                        NumericVector target_spacing, NumericVector source_spacing,
+                        NumericVector target_orientation, NumericVector source_orientation,
+                        int z_first, int z_last, int nthreads = 1) {
+  const char *caller = "rigid_resample_cpp";
+  RigidTransform tr = rigid_arguments(params, center, target_spacing, source_spacing,
+                                      target_orientation, source_orientation, caller);
+  TypedVolume t = typed_volume(target, caller);
+  TypedVolume s = typed_volume(source, caller);
+  require_image_storage(t, caller);
+  require_image_storage(s, caller);
+  if (z_first < 0 || z_last >= t.n_slices || z_first > z_last) {
+    stop("rigid_resample_cpp: slice range is out of bounds.");
+  }
+  if (nthreads < 1) nthreads = 1;
+#ifndef _OPENMP
+  nthreads = 1;
+#endif
+
+  int n_out = z_last - z_first + 1;
+  RObject out = t.xyz ? new_typed_volume(s.type, IntegerVector::create(t.ncol, t.nrow, n_out))
+                      : new_typed_volume(s.type, IntegerVector::create(n_out, t.nrow, t.ncol));
+  copy_layout(target, out);
+  VolumeLayout out_layout = t.xyz ? xyz_layout(n_out, t.nrow, t.ncol) : zyx_layout(n_out, t.nrow, t.ncol);
+  RigidResampleTask task = {volume_layout(s), out_layout, tr, z_first, z_last, storage_data(out), nthreads};
+  dispatch_storage_pair(t, s, task, caller);
+  return out;
+}
@@ -0,0 +1,70 @@
+#ifndef NPDS4CLIB_SEGMENT_LUNG_SLICE_H
+#define NPDS4CLIB_SEGMENT_LUNG_SLICE_H
+
+#include <vector>
+#include <cstddef>
+#include "bitmask.h"
+#include "bwlabel.h"
+#include "regionprops.h"
+#include "lung_regions.h"
+
+// 单张切片肺分割的工作区：前景与边界区域的位掩膜、标记、并查集、区域统计与保留表，可在多张切片之间复用
+struct LungSliceWork {
+  BitMask fg, border;
+  std::vector<int> labels;
+  BWLabelWork bwlabel;
+  std::vector<RegionProps> props;
+  std::vector<char> keep;
+  std::vector<int> valid_regions;
+};
+
+// 单张切片的肺分割：阈值化、清除边界、区域筛选共用同一次连通区域标记
+// 阈值化得到按位打包的前景掩膜；丢弃接触边界的区域时（cfg.drop_border），先在掩膜上按字清除与边界相连的区域，
+// 标记与区域统计只处理剩下的区域。被清除的正是 _regionprops 中 on_border 的区域，其余区域的相对编号不变，
+// 因此保留的区域与对完整前景标记后再筛选相同
+// im 为输入切片，(i, j) 像素位于 im[i * row_stride + j * col_stride]，out_im 与 binary 使用相同的步长，
+// 因此既可以处理单个矩阵，也可以直接处理 [z, y, x] 体数据中的一张切片而无需拷贝
+// work 为工作区，标记写在 work.labels 中；connectivity 为 4 或 8；cfg 为区域筛选参数
+// T 为切片的存储类型（double、int16、float32），out_im 与输入同类型；B 为掩膜类型（R 的 logical 为 int，紧凑存储为 uint8）
+// 返回保留下来的区域数量
+template <class T, class B>
+int _segment_lung_slice(const T *im, T *out_im, B *binary, LungSliceWork &work,
+                        XYPoint size, std::ptrdiff_t row_stride, std::ptrdiff_t col_stride,
+                        double threshold, int buffer_size, int connectivity,
+                        const LungRegionConfig &cfg) {
+  int nrow = size.x;
+  int ncol = size.y;
+
+  // 阈值化为位掩膜，清除与边界相连的区域后在掩膜上标记
+  _bitmask_threshold(im, size, row_stride, col_stride, threshold, work.fg);
+  if (cfg.drop_border) {
+    _bitmask_border_regions(work.fg, buffer_size + 1, connectivity, work.border);
+    _bitmask_andnot(work.fg, work.border, work.fg);
+  }
+  work.labels.resize(static_cast<std::size_t>(nrow) * ncol);
+  int *labels = work.labels.data();
+  int num_labels = _bwlabel(work.fg, labels, connectivity, work.bwlabel);
+
+  // 一次遍历统计每个标签的面积、边界框以及是否与图像边界相连
+  _regionprops(labels, work.fg, num_labels, buffer_size, work.props);
+
+  // 按 cfg 筛选肺区域，得到按标签索引的保留表
+  const std::vector<char> &keep = work.keep;
+  int n_kept = _select_lung_regions(work.props, size, cfg, work.keep, work.valid_regions);
+
+  // 写出肺掩膜与去除非肺区域后的切片；背景像素不读取标签
+  for (int j = 0; j < ncol; j++) {
+    const uint64_t *fg = work.fg.column(j);
+    const int *col_labels = labels + static_cast<std::ptrdiff_t>(j) * nrow;
+    for (int i = 0; i < nrow; i++) {
+      std::ptrdiff_t k = i * row_stride + j * col_stride;
+      int inside = ((fg[i >> 6] >> (i & 63)) & 1) ? keep[col_labels[i]] : 0;
+      binary[k] = static_cast<B>(inside);
+      out_im[k] = inside ? im[k] : T(0);
+    }
+  }
+
+  return n_kept;
+}
+
+#endif
@@ -0,0 +1,33 @@
+#include <Rcpp.h>
+#include "npds_core.h"
+#include "volume_utils.h"
+using namespace Rcpp;
+
+// workspace 为 npds_workspace() 创建的工作区时，标记与区域统计工作区取自其中，逐张切片调用时不再重新分配
+// [[Rcpp::export]]
+List segment_lung_slice_cpp(NumericMatrix im, double threshold = -400, int buffer_size = 0,
+                            int connectivity = 4, int top_k = 2, int min_area = 0,
+                            int max_extent = -1, SEXP workspace = R_NilValue) {
+  if (connectivity != 4 && connectivity != 8) {
+    stop("segment_lung_slice_cpp: connectivity must be 4 or 8.");
+  }
+  int nrow = im.nrow();
+  int ncol = im.ncol();
+
+  NumericMatrix out_im(nrow, ncol);
+  LogicalMatrix binary(nrow, ncol);
+  npds::SegmentOptions options;
+  options.threshold = threshold;
+  options.buffer_size = buffer_size;
+  options.connectivity = connectivity;
+  options.top_k = top_k;
+  options.min_area = min_area;
+  options.max_extent = max_extent;
+  NPDSWorkspace local;
+  NPDSWorkspace *ws = workspace_arg(workspace, local, 1, "segment_lung_slice_cpp");
+
+  npds::segment_lung_slice(REAL(im), nrow, ncol, REAL(out_im), LOGICAL(binary), options, ws->threads[0].lung);
+
+  return List::create(Named("im") = out_im,
+                      Named("binary") = binary);
+}
@@ -0,0 +1,153 @@
+#include <Rcpp.h>
+#include <vector>
+#include <cstddef>
+#include "bwlabel3d.h"
+#include "lung_regions.h"
+#include "typed_volume.h"
+#include "volume_utils.h"
+using namespace Rcpp;
+
+// 整个体数据的肺分割：阈值化后做一次三维连通区域标记，清除接触层面边界的区域，
+// 再在整个体数据上按体素数筛选肺区域，避免逐层筛选时相邻切片保留的区域不一致
+// labels 为与体数据同样大小的工作区；返回保留下来的区域数量
+// T、B 的含义与 _segment_lung_slice 相同；(n0, n1, n2) 为内存中的维度，z_last 的含义与 _regionprops3d 相同
+// 连通区域标记与布局无关，两种布局只在边界框和边界的判断上交换坐标轴
+template <class T, class B>
+int _segment_lungs_volume3d(const T *im, T *out_im, B *binary, int *labels,
+                            int n0, int n1, int n2, double threshold, int buffer_size,
+                            int connectivity, bool clear_z_border, const LungRegionConfig &cfg,
+                            bool z_last = false) {
+  std::ptrdiff_t n = static_cast<std::ptrdiff_t>(n0) * n1 * n2;
+
+  for (std::ptrdiff_t i = 0; i < n; i++) {
+    labels[i] = (im[i] < threshold) ? 1 : 0;
+  }
+  int num_labels = _bwlabel3d(labels, labels, n0, n1, n2, connectivity);
+
+  std::vector<RegionProps> props;
+  _regionprops3d(labels, num_labels, n0, n1, n2, buffer_size, clear_z_border, props, z_last);
+
+  // 层面内的边界框跨度限制按 (y, x) 的大小换算
+  XYPoint size = {n1, z_last ? n0 : n2};
+  std::vector<char> keep;
+  int n_kept = _select_lung_regions(props, size, cfg, keep);
+
+  for (std::ptrdiff_t i = 0; i < n; i++) {
+    int inside = keep[labels[i]];
+    binary[i] = static_cast<B>(inside);
+    out_im[i] = inside ? im[i] : T(0);
+  }
+
+  return n_kept;
+}
+
+// 三维连通区域标记，返回标签数组、区域数量以及每个区域的体素数
+// [[Rcpp::export]]
+List bwlabel3d(NumericVector x, int connectivity = 26) {
+  if (connectivity != 6 && connectivity != 18 && connectivity != 26) {
+    stop("bwlabel3d: connectivity must be 6, 18 or 26.");
+  }
+  int n0, n1, n2;
+  volume_dims(x, n0, n1, n2, "bwlabel3d");
+
+  IntegerVector res(x.size());
+  res.attr("dim") = x.attr("dim");
+  int num_labels = _bwlabel3d(REAL(x), INTEGER(res), n0, n1, n2, connectivity);
+
+  IntegerVector voxel_counts(num_labels);
+  const int *labels = INTEGER(res);
+  for (R_xlen_t i = 0; i < res.size(); i++) {
+    if (labels[i] > 0) voxel_counts[labels[i] - 1]++;
+  }
+
+  return List::create(Named("labeled_image") = res,
+                      Named("num_labels") = num_labels,
+                      Named("voxel_counts") = voxel_counts);
+}
+
+// 按存储类型选择 _segment_lungs_volume3d 的模板实例；out 与 in 同类型，binary 为 mask_storage(in.type) 对应的类型
+static void segment_typed_volume3d(const TypedVolume &in, void *out, void *binary, int *labels,
+                                   double threshold, int buffer_size, int connectivity,
+                                   bool clear_z_border, const LungRegionConfig &cfg) {
+  // 内存中的维度：[z, y, x] 或 NIfTI 原始布局的 [x, y, z]
+  int n0 = in.xyz ? in.ncol : in.n_slices;
+  int n2 = in.xyz ? in.n_slices : in.ncol;
+  switch (in.type) {
+  case STORAGE_INT16:
+    _segment_lungs_volume3d(static_cast<const int16_t *>(in.data), static_cast<int16_t *>(out),
+                            static_cast<uint8_t *>(binary), labels, n0, in.nrow, n2,
+                            threshold, buffer_size, connectivity, clear_z_border, cfg, in.xyz);
+    break;
+  case STORAGE_FLOAT32:
+    _segment_lungs_volume3d(static_cast<const float *>(in.data), static_cast<float *>(out),
+                            static_cast<uint8_t *>(binary), labels, n0, in.nrow, n2,
+                            threshold, buffer_size, connectivity, clear_z_border, cfg, in.xyz);
+    break;
+  default:
+    _segment_lungs_volume3d(static_cast<const double *>(in.data), static_cast<double *>(out),
+                            static_cast<int *>(binary), labels, n0, in.nrow, n2,
+                            threshold, buffer_size, connectivity, clear_z_border, cfg, in.xyz);
+    break;
+  }
+}
+
+// 子区域的存储类型和布局与 segment_lungs_volume_cpp 相同
+// workspace 为 npds_workspace() 创建的工作区时，两期的标记数组取自其中
+// [[Rcpp::export]]
+List segment_lungs_volume3d_cpp(SEXP bf_sub_image,
+                                SEXP af_sub_image,
+                                int nthreads = 1,
+                                double threshold = -400,
+                                int buffer_size = 0,
+                                int connectivity = 26,
+                                int top_k = 2,
+                                int min_voxels = 0,
+                                int max_extent = -1,
+                                bool clear_z_border = false,
+                                SEXP workspace = R_NilValue) {
+  if (connectivity != 6 && connectivity != 18 && connectivity != 26) {
+    stop("segment_lungs_volume3d_cpp: connectivity must be 6, 18 or 26.");
+  }
+  // af_sub_image 为 NULL 时只分割 bf_sub_image，结果中 af 的两项为 NULL
+  int n_volumes = Rf_isNull(af_sub_image) ? 1 : 2;
+  SEXP images[2] = {bf_sub_image, af_sub_image};
+  TypedVolume in[2];
+  RObject outputs[2], binaries[2];
+  void *out[2], *binary[2];
+  for (int s = 0; s < n_volumes; s++) {
+    in[s] = typed_volume(images[s], "segment_lungs_volume3d_cpp");
+    require_image_storage(in[s], "segment_lungs_volume3d_cpp");
+    outputs[s] = new_typed_volume(in[s].type, typed_volume_dim(images[s]));
+    binaries[s] = new_typed_volume(mask_storage(in[s].type), typed_volume_dim(images[s]));
+    copy_layout(images[s], outputs[s]);
+    copy_layout(images[s], binaries[s]);
+    out[s] = storage_data(outputs[s]);
+    binary[s] = storage_data(binaries[s]);
+  }
+  LungRegionConfig cfg = {top_k, min_voxels, max_extent, true};
+
+  if (nthreads < 1) nthreads = 1;
+  if (nthreads > n_volumes) nthreads = n_volumes;
+#ifndef _OPENMP
+  nthreads = 1;
+#endif
+
+  // 两次扫描各自一块标记工作区，在并行区之外准备
+  NPDSWorkspace local;
+  NPDSWorkspace *ws = workspace_arg(workspace, local, nthreads, "segment_lungs_volume3d_cpp");
+  std::vector<int> *labels = ws->volume_labels;
+  for (int s = 0; s < n_volumes; s++) labels[s].resize(in[s].n);
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(nthreads) schedule(static)
+#endif
+  for (int s = 0; s < n_volumes; s++) {
+    segment_typed_volume3d(in[s], out[s], binary[s], labels[s].data(),
+                           threshold, buffer_size, connectivity, clear_z_border, cfg);
+  }
+
+  return List::create(Named("bf_sub_image") = outputs[0],
+                      Named("af_sub_image") = outputs[1],
+                      Named("bf_sub_binary") = binaries[0],
+                      Named("af_sub_binary") = binaries[1]);
+}
@@ -0,0 +1,62 @@
+#include <Rcpp.h>
+#include "npds_core.h"
+#include "typed_volume.h"
+#include "volume_utils.h"
+using namespace Rcpp;
+
+// 子区域可以是 double 数组，也可以是 npds_storage() 生成的 int16 / float32 体数据；
+// 分割后的图像与输入同类型，掩膜为 logical（double 输入）或 uint8（紧凑存储的输入）
+// 带 npds_layout = "xyz" 属性的子区域按 NIfTI 原始布局读取，输出保持同样的布局
+// workspace 为 npds_workspace() 创建的工作区时，每个线程的标记与区域统计工作区取自其中
+// 分割本身为 npds_core.h 中的 npds::segment_lungs，输入直接使用 R 对象的数据
+// [[Rcpp::export]]
+List segment_lungs_volume_cpp(SEXP bf_sub_image,
+                              SEXP af_sub_image,
+                              int nthreads = 1,
+                              double threshold = -400,
+                              int buffer_size = 0,
+                              int connectivity = 4,
+                              int top_k = 2,
+                              int min_area = 0,
+                              int max_extent = -1,
+                              SEXP workspace = R_NilValue) {
+  if (connectivity != 4 && connectivity != 8) {
+    stop("segment_lungs_volume_cpp: connectivity must be 4 or 8.");
+  }
+  // af_sub_image 为 NULL 时只分割 bf_sub_image（例如纵向序列中逐个时间点分割），结果中 af 的两项为 NULL
+  int n_volumes = Rf_isNull(af_sub_image) ? 1 : 2;
+  SEXP images[2] = {bf_sub_image, af_sub_image};
+  TypedVolume in[2];
+  RObject outputs[2], binaries[2];
+  void *out[2], *binary[2];
+  for (int s = 0; s < n_volumes; s++) {
+    in[s] = typed_volume(images[s], "segment_lungs_volume_cpp");
+    require_image_storage(in[s], "segment_lungs_volume_cpp");
+
+    // 输出与输入维度、存储类型一致
+    outputs[s] = new_typed_volume(in[s].type, typed_volume_dim(images[s]));
+    binaries[s] = new_typed_volume(mask_storage(in[s].type), typed_volume_dim(images[s]));
+    copy_layout(images[s], outputs[s]);
+    copy_layout(images[s], binaries[s]);
+    out[s] = storage_data(outputs[s]);
+    binary[s] = storage_data(binaries[s]);
+  }
+
+  npds::SegmentOptions options;
+  options.threshold = threshold;
+  options.buffer_size = buffer_size;
+  options.connectivity = connectivity;
+  options.top_k = top_k;
+  options.min_area = min_area;
+  options.max_extent = max_extent;
+
+  // 基线和随访的所有切片在 npds::segment_lungs 中合并为一个任务列表
+  NPDSWorkspace local;
+  NPDSWorkspace *ws = workspace_arg(workspace, local, nthreads, "segment_lungs_volume_cpp");
+  npds::segment_lungs(in, out, binary, n_volumes, options, nthreads, ws);
+
+  return List::create(Named("bf_sub_image") = outputs[0],
+                      Named("af_sub_image") = outputs[1],
+                      Named("bf_sub_binary") = binaries[0],
+                      Named("af_sub_binary") = binaries[1]);
+}
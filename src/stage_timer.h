@@ -0,0 +1,47 @@
+#ifndef NPDS4CLIB_STAGE_TIMER_H
+#define NPDS4CLIB_STAGE_TIMER_H
+
+#include <chrono>
+#include <ctime>
+
+// 热路径上的分步计时：每一步只读取一次墙钟时间（steady_clock）和一次进程 CPU 时间（std::clock，包括所有线程）
+// 不计时时 times 为 NULL，除一次指针判断外没有开销；Windows 上 std::clock 返回的是墙钟时间
+struct StageTimes {
+  enum { max_steps = 8 };
+  const char *name[max_steps];
+  double wall[max_steps], cpu[max_steps];
+  int n;
+};
+
+struct StageTimer {
+  StageTimes *times;
+  std::chrono::steady_clock::time_point wall;
+  std::clock_t cpu;
+};
+
+inline StageTimer _stage_timer(StageTimes *times) {
+  StageTimer timer;
+  timer.times = times;
+  if (times != NULL) {
+    times->n = 0;
+    timer.wall = std::chrono::steady_clock::now();
+    timer.cpu = std::clock();
+  }
+  return timer;
+}
+
+// 结束当前一步并记为 name，同时开始下一步
+inline void _stage_lap(StageTimer &timer, const char *name) {
+  StageTimes *times = timer.times;
+  if (times == NULL || times->n >= StageTimes::max_steps) return;
+  std::chrono::steady_clock::time_point wall = std::chrono::steady_clock::now();
+  std::clock_t cpu = std::clock();
+  int k = times->n++;
+  times->name[k] = name;
+  times->wall[k] = std::chrono::duration<double>(wall - timer.wall).count();
+  times->cpu[k] = static_cast<double>(cpu - timer.cpu) / CLOCKS_PER_SEC;
+  timer.wall = wall;
+  timer.cpu = cpu;
+}
+
+#endif
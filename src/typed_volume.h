@@ -0,0 +1,123 @@
+#ifndef NPDS4CLIB_TYPED_VOLUME_H
+#define NPDS4CLIB_TYPED_VOLUME_H
+
+#include <Rcpp.h>
+#include <cstring>
+#include <string>
+#include "volume.h"
+#include "volume_utils.h"
+
+// 紧凑存储的体数据
+// R 没有 int16 / float32 / uint8 数组，紧凑存储的体数据保存为 raw 向量：
+//   属性 npds_storage 为存储类型（"int16"、"float32" 或 "uint8"）
+//   属性 npds_dim 为逻辑维度（与 double 数组的 dim 相同，[z, y, x]）
+// double 数组、logical 数组（掩膜）照常使用 R 自身的类型
+// 属性 npds_layout 为 "xyz" 时数据保持 NIfTI 文件的原始顺序（x 变化最快），dim / npds_dim 为 (x, y, z)
+// 这里只负责 R 对象与 volume.h 中 TypedVolume 之间的转换，TypedVolume 直接指向 R 对象的数据，不复制
+
+// 是否带有 npds_layout = "xyz" 属性
+inline bool is_xyz_layout(SEXP x) {
+  SEXP layout = Rf_getAttrib(x, Rf_install("npds_layout"));
+  return TYPEOF(layout) == STRSXP && Rf_xlength(layout) > 0 && std::strcmp(CHAR(STRING_ELT(layout, 0)), "xyz") == 0;
+}
+
+// 把 from 的布局属性复制到 to
+inline void copy_layout(SEXP from, SEXP to) {
+  if (!is_xyz_layout(from)) return;
+  // Rf_mkString 的结果在 Rf_install 与 Rf_setAttrib 分配内存时必须受保护
+  SEXP tag = PROTECT(Rf_mkString("xyz"));
+  Rf_setAttrib(to, Rf_install("npds_layout"), tag);
+  UNPROTECT(1);
+}
+
+// R 对象中数据的起始地址
+inline void *storage_data(SEXP x) {
+  switch (TYPEOF(x)) {
+  case REALSXP: return REAL(x);
+  case LGLSXP: return LOGICAL(x);
+  default: return RAW(x);
+  }
+}
+
+// NIfTI 原始布局的维度 (x, y, z) 读入时按 [z, y, x] 的顺序存放，这里换回逻辑维度
+inline void xyz_dims(TypedVolume &v, const char *caller) {
+  if (v.n_slices == 1 && v.n != static_cast<R_xlen_t>(v.nrow) * v.ncol) {
+    Rcpp::stop(std::string(caller) + ": an \"xyz\" volume must be a 3D array of [x, y, z].");
+  }
+  int nx = v.n_slices, ny = v.nrow, nz = v.ncol;
+  v.n_slices = nz;
+  v.nrow = ny;
+  v.ncol = nx;
+}
+
+// 读取体数据的存储类型、数据指针和维度
+inline TypedVolume typed_volume(SEXP x, const char *caller = "typed_volume") {
+  TypedVolume v;
+  v.xyz = is_xyz_layout(x);
+  if (TYPEOF(x) == REALSXP || TYPEOF(x) == LGLSXP) {
+    v.type = TYPEOF(x) == REALSXP ? STORAGE_DOUBLE : STORAGE_LOGICAL;
+    v.data = storage_data(x);
+    volume_dims(x, v.n_slices, v.nrow, v.ncol, caller);
+    v.n = Rf_xlength(x);
+    if (v.xyz) xyz_dims(v, caller);
+    return v;
+  }
+
+  SEXP storage = Rf_getAttrib(x, Rf_install("npds_storage"));
+  SEXP dim_attr = Rf_getAttrib(x, Rf_install("npds_dim"));
+  if (TYPEOF(x) != RAWSXP || TYPEOF(storage) != STRSXP || Rf_isNull(dim_attr)) {
+    Rcpp::stop(std::string(caller) + ": image must be a double array or a volume created by npds_storage().");
+  }
+  v.type = parse_storage(CHAR(STRING_ELT(storage, 0)), caller);
+  v.data = storage_data(x);
+
+  Rcpp::IntegerVector dims(dim_attr);
+  if (dims.size() == 3) {
+    v.n_slices = dims[0];
+    v.nrow = dims[1];
+    v.ncol = dims[2];
+  } else if (dims.size() == 2) {
+    v.n_slices = 1;
+    v.nrow = dims[0];
+    v.ncol = dims[1];
+  } else {
+    Rcpp::stop(std::string(caller) + ": image must be a 3D array of [z, y, x].");
+  }
+  v.n = static_cast<R_xlen_t>(v.n_slices) * v.nrow * v.ncol;
+  if (static_cast<std::size_t>(Rf_xlength(x)) != v.n * storage_bytes(v.type)) {
+    Rcpp::stop(std::string(caller) + ": npds_dim does not match the stored data.");
+  }
+  if (v.xyz) xyz_dims(v, caller);
+  return v;
+}
+
+// 新建与 dims 同样维度的体数据；double 与 logical 使用 R 的 dim 属性，其余类型为带属性的 raw 向量
+// 新建的体数据没有 npds_layout 属性，需要时用 copy_layout 复制
+inline SEXP new_typed_volume(StorageType type, SEXP dims) {
+  R_xlen_t n = 1;
+  Rcpp::IntegerVector d(dims);
+  for (int k = 0; k < d.size(); k++) n *= d[k];
+
+  SEXP out;
+  if (type == STORAGE_DOUBLE || type == STORAGE_LOGICAL) {
+    out = PROTECT(Rf_allocVector(type == STORAGE_DOUBLE ? REALSXP : LGLSXP, n));
+    Rf_setAttrib(out, R_DimSymbol, d);
+  } else {
+    out = PROTECT(Rf_allocVector(RAWSXP, n * storage_bytes(type)));
+    SEXP name = PROTECT(Rf_mkString(storage_name(type)));
+    Rf_setAttrib(out, Rf_install("npds_storage"), name);
+    Rf_setAttrib(out, Rf_install("npds_dim"), d);
+    UNPROTECT(1);
+  }
+  std::memset(storage_data(out), 0, n * storage_bytes(type));
+  UNPROTECT(1);
+  return out;
+}
+
+// 体数据的逻辑维度（dim 或 npds_dim）
+inline SEXP typed_volume_dim(SEXP x) {
+  SEXP d = Rf_getAttrib(x, Rf_install("npds_dim"));
+  return Rf_isNull(d) ? Rf_getAttrib(x, R_DimSymbol) : d;
+}
+
+#endif
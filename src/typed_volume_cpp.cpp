@@ -0,0 +1,158 @@
+#include <Rcpp.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include "typed_volume.h"
+using namespace Rcpp;
+
+// 按存储类型写出 double 数据，取值规则见 store_value
+template <class T>
+static void encode_values(const double *x, R_xlen_t n, T *out) {
+  for (R_xlen_t i = 0; i < n; i++) store_value(x[i], out[i]);
+}
+
+// 逐元素转换为 double
+struct DecodeTask {
+  double *out;
+  R_xlen_t n;
+
+  template <class T>
+  void operator()(const T *x) {
+    for (R_xlen_t i = 0; i < n; i++) out[i] = static_cast<double>(x[i]);
+  }
+};
+
+// 把 double（或 logical）数组转换为紧凑存储；storage 为 "double"、"int16"、"float32" 或 "uint8"
+// 数据顺序不变，npds_layout 属性随之保留
+// [[Rcpp::export]]
+SEXP encode_volume_cpp(NumericVector x, std::string storage = "int16") {
+  StorageType type = parse_storage(storage, "encode_volume_cpp");
+  SEXP dims = Rf_getAttrib(x, R_DimSymbol);
+  if (Rf_isNull(dims)) {
+    stop("encode_volume_cpp: x must be an array.");
+  }
+
+  RObject out = new_typed_volume(type, dims);
+  R_xlen_t n = x.size();
+  switch (type) {
+  case STORAGE_INT16: encode_values(REAL(x), n, static_cast<int16_t *>(storage_data(out))); break;
+  case STORAGE_FLOAT32: encode_values(REAL(x), n, static_cast<float *>(storage_data(out))); break;
+  case STORAGE_UINT8: encode_values(REAL(x), n, static_cast<uint8_t *>(storage_data(out))); break;
+  default: std::copy(x.begin(), x.end(), REAL(out)); break;
+  }
+  copy_layout(x, out);
+  return out;
+}
+
+// NIfTI 原始顺序 [x, y, z] 的 double 数据转置为 [z, y, x] 并按存储类型写出，转置与类型转换在同一遍中完成
+// 按 32 张切片一组处理，使每个 (y, x) 位置写出一段连续的切片
+template <class T>
+static void encode_transposed(const double *x, int nx, int ny, int nz, T *out) {
+  const int tile = 32;
+  std::ptrdiff_t plane = static_cast<std::ptrdiff_t>(nx) * ny;
+  for (int k0 = 0; k0 < nz; k0 += tile) {
+    int k1 = std::min(nz, k0 + tile);
+    for (int j = 0; j < ny; j++) {
+      for (int i = 0; i < nx; i++) {
+        const double *src = x + i + static_cast<std::ptrdiff_t>(nx) * j;
+        T *dst = out + (static_cast<std::ptrdiff_t>(i) * ny + j) * nz;
+        for (int k = k0; k < k1; k++) store_value(src[k * plane], dst[k]);
+      }
+    }
+  }
+}
+
+// 把 NIfTI 对象的数据（原始顺序 [x, y, z] 的 double 数组）直接写成 initialization 使用的体数据
+// layout 为 "zyx" 时在同一遍中转置为 [z, y, x]，为 "xyz" 时保持原始顺序并标记 npds_layout = "xyz"
+// 只分配结果，不再生成 aperm 或去掉属性时的 double 副本；第 4 维及以后的维度必须为 1
+// [[Rcpp::export]]
+SEXP encode_nifti_cpp(NumericVector x, std::string storage = "double", std::string layout = "zyx") {
+  const char *caller = "encode_nifti_cpp";
+  StorageType type = parse_storage(storage, caller);
+  if (layout != "zyx" && layout != "xyz") {
+    stop("encode_nifti_cpp: layout must be \"zyx\" or \"xyz\".");
+  }
+  SEXP dim_attr = Rf_getAttrib(x, R_DimSymbol);
+  if (Rf_isNull(dim_attr) || Rf_length(dim_attr) < 3) {
+    stop("encode_nifti_cpp: x must be a 3D array of [x, y, z].");
+  }
+  IntegerVector d(dim_attr);
+  int nx = d[0], ny = d[1], nz = d[2];
+  R_xlen_t n = static_cast<R_xlen_t>(nx) * ny * nz;
+  if (x.size() != n) {
+    stop("encode_nifti_cpp: x must be a 3D array of [x, y, z].");
+  }
+
+  bool xyz = layout == "xyz";
+  RObject out = xyz ? new_typed_volume(type, IntegerVector::create(nx, ny, nz))
+                    : new_typed_volume(type, IntegerVector::create(nz, ny, nx));
+  void *data = storage_data(out);
+  if (xyz) {
+    switch (type) {
+    case STORAGE_INT16: encode_values(REAL(x), n, static_cast<int16_t *>(data)); break;
+    case STORAGE_FLOAT32: encode_values(REAL(x), n, static_cast<float *>(data)); break;
+    case STORAGE_UINT8: encode_values(REAL(x), n, static_cast<uint8_t *>(data)); break;
+    default: std::copy(x.begin(), x.end(), REAL(out)); break;
+    }
+    SEXP tag = PROTECT(Rf_mkString("xyz"));
+    Rf_setAttrib(out, Rf_install("npds_layout"), tag);
+    UNPROTECT(1);
+  } else {
+    switch (type) {
+    case STORAGE_INT16: encode_transposed(REAL(x), nx, ny, nz, static_cast<int16_t *>(data)); break;
+    case STORAGE_FLOAT32: encode_transposed(REAL(x), nx, ny, nz, static_cast<float *>(data)); break;
+    case STORAGE_UINT8: encode_transposed(REAL(x), nx, ny, nz, static_cast<uint8_t *>(data)); break;
+    default: encode_transposed(REAL(x), nx, ny, nz, REAL(out)); break;
+    }
+  }
+  return out;
+}
+
+// 把紧凑存储的体数据还原为 double 数组（维度取自 npds_dim），数据顺序和 npds_layout 属性不变
+// [[Rcpp::export]]
+NumericVector decode_volume_cpp(SEXP x) {
+  if (TYPEOF(x) == REALSXP) return NumericVector(x);
+
+  TypedVolume v = typed_volume(x, "decode_volume_cpp");
+  NumericVector out(v.n);
+  out.attr("dim") = typed_volume_dim(x);
+  copy_layout(x, out);
+  DecodeTask task = {REAL(out), v.n};
+  dispatch_storage(v, task);
+  return out;
+}
+
+// 取出第 first 到第 last 张切片（从 1 开始，包含两端），存储类型和布局不变，结果总是三维
+// [z, y, x] 布局的结果维度为 c(n_out, y, x)；NIfTI 原始布局的结果维度为 c(x, y, n_out)
+// [[Rcpp::export]]
+SEXP subset_slices_cpp(SEXP x, int first, int last) {
+  TypedVolume v = typed_volume(x, "subset_slices_cpp");
+  if (first < 1 || last > v.n_slices || first > last) {
+    stop("subset_slices_cpp: slice range is out of bounds.");
+  }
+
+  int n_out = last - first + 1;
+  std::size_t bytes = storage_bytes(v.type);
+  const char *src = static_cast<const char *>(v.data);
+
+  if (v.xyz) {
+    // 每张切片是一段连续的 x * y 个体素，切片范围整体只需一次拷贝
+    RObject out = new_typed_volume(v.type, IntegerVector::create(v.ncol, v.nrow, n_out));
+    std::size_t plane_bytes = static_cast<std::size_t>(v.nrow) * v.ncol * bytes;
+    std::memcpy(storage_data(out), src + (first - 1) * plane_bytes, n_out * plane_bytes);
+    copy_layout(x, out);
+    return out;
+  }
+
+  RObject out = new_typed_volume(v.type, IntegerVector::create(n_out, v.nrow, v.ncol));
+  char *dst = static_cast<char *>(storage_data(out));
+
+  // z 方向连续存储，每个 (y, x) 位置拷贝一段连续的切片
+  R_xlen_t n_columns = static_cast<R_xlen_t>(v.nrow) * v.ncol;
+  for (R_xlen_t c = 0; c < n_columns; c++) {
+    std::memcpy(dst + c * n_out * bytes, src + (c * v.n_slices + first - 1) * bytes, n_out * bytes);
+  }
+  return out;
+}
@@ -0,0 +1,153 @@
+#ifndef NPDS4CLIB_VOLUME_H
+#define NPDS4CLIB_VOLUME_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "block_view.h"
+#include "npds_error.h"
+
+// 按存储类型描述的体数据，不依赖 R
+// TypedVolume 只记录数据指针、存储类型、逻辑维度 [z, y, x] 和布局，不拥有数据；
+// R 对象与它之间的转换见 typed_volume.h，R 之外由调用者直接填写
+// 各个核函数按输入类型模板化，直接处理这些类型，不需要先转换回 double
+// xyz 为 true 时数据为 NIfTI 文件的原始顺序（x 变化最快），否则为 [z, y, x]；核函数通过步长（VolumeLayout）读取两种布局
+
+enum StorageType {
+  STORAGE_DOUBLE,
+  STORAGE_LOGICAL,
+  STORAGE_INT16,
+  STORAGE_FLOAT32,
+  STORAGE_UINT8
+};
+
+struct TypedVolume {
+  StorageType type;
+  void *data;
+  int n_slices, nrow, ncol;  // 逻辑维度 [z, y, x]
+  std::ptrdiff_t n;  // 元素个数
+  bool xyz;    // 是否为 NIfTI 原始布局
+};
+
+// 体数据的内存布局
+inline VolumeLayout volume_layout(const TypedVolume &v) {
+  return v.xyz ? xyz_layout(v.n_slices, v.nrow, v.ncol) : zyx_layout(v.n_slices, v.nrow, v.ncol);
+}
+
+inline const char *storage_name(StorageType type) {
+  switch (type) {
+  case STORAGE_DOUBLE: return "double";
+  case STORAGE_LOGICAL: return "logical";
+  case STORAGE_INT16: return "int16";
+  case STORAGE_FLOAT32: return "float32";
+  case STORAGE_UINT8: return "uint8";
+  }
+  return "unknown";
+}
+
+inline std::size_t storage_bytes(StorageType type) {
+  switch (type) {
+  case STORAGE_DOUBLE: return sizeof(double);
+  case STORAGE_LOGICAL: return sizeof(int);
+  case STORAGE_INT16: return sizeof(int16_t);
+  case STORAGE_FLOAT32: return sizeof(float);
+  case STORAGE_UINT8: return sizeof(uint8_t);
+  }
+  return 0;
+}
+
+inline StorageType parse_storage(const std::string &name, const char *caller) {
+  if (name == "double") return STORAGE_DOUBLE;
+  if (name == "int16") return STORAGE_INT16;
+  if (name == "float32") return STORAGE_FLOAT32;
+  if (name == "uint8") return STORAGE_UINT8;
+  npds_stop(std::string(caller) + ": storage must be one of \"double\", \"int16\", \"float32\" or \"uint8\".");
+  return STORAGE_DOUBLE;
+}
+
+// CT 图像只支持 double、int16、float32 三种存储
+inline void require_image_storage(const TypedVolume &v, const char *caller) {
+  if (v.type != STORAGE_DOUBLE && v.type != STORAGE_INT16 && v.type != STORAGE_FLOAT32) {
+    npds_stop(std::string(caller) + ": image must be stored as double, int16 or float32.");
+  }
+}
+
+// 与图像对应的掩膜存储：double 图像的掩膜为 logical，紧凑存储的图像掩膜为 uint8
+inline StorageType mask_storage(StorageType image_type) {
+  return image_type == STORAGE_DOUBLE ? STORAGE_LOGICAL : STORAGE_UINT8;
+}
+
+// 按存储类型写出一个 double 值
+// int16 四舍五入后截断到 [-32768, 32767]，NaN 记为 0；uint8 用于掩膜，非零即为 1
+inline void store_value(double v, double &out) { out = v; }
+inline void store_value(double v, float &out) { out = static_cast<float>(v); }
+inline void store_value(double v, int16_t &out) {
+  if (std::isnan(v)) {
+    out = 0;
+  } else if (v <= -32768.0) {
+    out = -32768;
+  } else if (v >= 32767.0) {
+    out = 32767;
+  } else {
+    out = static_cast<int16_t>(std::lround(v));
+  }
+}
+inline void store_value(double v, uint8_t &out) { out = (v != 0 && !std::isnan(v)) ? 1 : 0; }
+
+// 按存储类型调用 f(const T *)；f 为带模板 operator() 的函数对象
+template <class F>
+inline void dispatch_storage(const TypedVolume &v, F &f) {
+  switch (v.type) {
+  case STORAGE_DOUBLE: f(static_cast<const double *>(v.data)); break;
+  case STORAGE_LOGICAL: f(static_cast<const int *>(v.data)); break;
+  case STORAGE_INT16: f(static_cast<const int16_t *>(v.data)); break;
+  case STORAGE_FLOAT32: f(static_cast<const float *>(v.data)); break;
+  case STORAGE_UINT8: f(static_cast<const uint8_t *>(v.data)); break;
+  }
+}
+
+// 按两期体数据共同的存储类型调用 f(const T *bf, const T *af)；两期的存储类型和布局必须相同
+template <class F>
+inline void dispatch_storage_pair(const TypedVolume &bf, const TypedVolume &af, F &f,
+                                  const char *caller = "dispatch_storage_pair") {
+  if (bf.type != af.type) {
+    npds_stop(std::string(caller) + ": bf_sub_image and af_sub_image must use the same storage.");
+  }
+  if (bf.xyz != af.xyz) {
+    npds_stop(std::string(caller) + ": bf_sub_image and af_sub_image must use the same layout.");
+  }
+  switch (bf.type) {
+  case STORAGE_DOUBLE: f(static_cast<const double *>(bf.data), static_cast<const double *>(af.data)); break;
+  case STORAGE_LOGICAL: f(static_cast<const int *>(bf.data), static_cast<const int *>(af.data)); break;
+  case STORAGE_INT16: f(static_cast<const int16_t *>(bf.data), static_cast<const int16_t *>(af.data)); break;
+  case STORAGE_FLOAT32: f(static_cast<const float *>(bf.data), static_cast<const float *>(af.data)); break;
+  case STORAGE_UINT8: f(static_cast<const uint8_t *>(bf.data), static_cast<const uint8_t *>(af.data)); break;
+  }
+}
+
+// 检查两期子区域维度一致、组织块与结节块都在子区域之内，返回每行每列的分块数 split_num
+// bf_dims、af_dims 为 {n_slices, nrow, ncol}
+inline int check_block_geometry(const int *bf_dims, const int *af_dims,
+                                int x_start, int y_start, int split_size, int image_size,
+                                const char *caller = "check_block_geometry") {
+  if (bf_dims[0] != af_dims[0] || bf_dims[1] != af_dims[1] || bf_dims[2] != af_dims[2]) {
+    npds_stop(std::string(caller) + ": bf_sub_image and af_sub_image must have the same dimensions.");
+  }
+  if (split_size <= 0) {
+    npds_stop(std::string(caller) + ": split_size must be positive.");
+  }
+
+  int nrow = bf_dims[1];
+  int ncol = bf_dims[2];
+  int split_num = image_size / split_size;
+  if (split_num * split_size > nrow || split_num * split_size > ncol) {
+    npds_stop(std::string(caller) + ": image_size exceeds the sub-image size.");
+  }
+  if (x_start < 0 || y_start < 0 || x_start + split_size > ncol || y_start + split_size > nrow) {
+    npds_stop(std::string(caller) + ": nodule block lies outside the sub-image.");
+  }
+  return split_num;
+}
+
+#endif
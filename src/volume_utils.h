@@ -0,0 +1,48 @@
+#ifndef NPDS4CLIB_VOLUME_UTILS_H
+#define NPDS4CLIB_VOLUME_UTILS_H
+
+#include <Rcpp.h>
+#include <string>
+#include "npds_workspace.h"
+#include "volume.h"
+
+// 读取 [z, y, x] 体数据的维度；单张切片（二维矩阵）视为 z = 1
+inline void volume_dims(SEXP image, int &n_slices, int &nrow, int &ncol,
+                        const char *caller = "volume_dims") {
+  SEXP dim_attr = Rf_getAttrib(image, R_DimSymbol);
+  Rcpp::IntegerVector dims = Rf_isNull(dim_attr) ? Rcpp::IntegerVector(0) : Rcpp::IntegerVector(dim_attr);
+  if (dims.size() == 3) {
+    n_slices = dims[0];
+    nrow = dims[1];
+    ncol = dims[2];
+  } else if (dims.size() == 2) {
+    n_slices = 1;
+    nrow = dims[0];
+    ncol = dims[1];
+  } else {
+    Rcpp::stop(std::string(caller) + ": image must be a 3D array of [z, y, x].");
+  }
+}
+
+// R 传入的工作区（npds_workspace() 创建的外部指针）；workspace 为 NULL 时使用 local
+// 保证工作区至少有 nthreads 个线程工作区，返回要使用的工作区
+inline NPDSWorkspace *workspace_arg(SEXP workspace, NPDSWorkspace &local, int nthreads,
+                                    const char *caller = "workspace_arg") {
+  NPDSWorkspace *ws = &local;
+  if (!Rf_isNull(workspace)) {
+    if (TYPEOF(workspace) != EXTPTRSXP || !Rf_inherits(workspace, "npds_workspace")) {
+      Rcpp::stop(std::string(caller) + ": workspace must be created with npds_workspace().");
+    }
+    ws = static_cast<NPDSWorkspace *>(R_ExternalPtrAddr(workspace));
+    // 外部指针不能保存：saveRDS / load 之后地址为空
+    if (ws == NULL) {
+      Rcpp::stop(std::string(caller) + ": the workspace is no longer valid (external pointers do not survive "
+                 "saving and loading); create a new one with npds_workspace().");
+    }
+  }
+  ws->reserve_threads(nthreads);
+  ws->uses++;
+  return ws;
+}
+
+#endif